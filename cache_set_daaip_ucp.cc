@@ -0,0 +1,414 @@
+#include "cache_set_daaip_ucp.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+#include "cache.h"
+#include "stats.h"
+#include "cache_set_stat_counter.h"
+#include "cache_set_daaip_ucp_rules.h"
+#include "hooks_manager.h"
+
+extern UInt64 g_cycles_count;
+
+#define MAX_ASSOCIATIVITY               64     // Largest set the UMON counters can track
+#define OWNER_NONE                      0xff
+
+static UInt8  g_iteration_count         = 0;
+static UInt32 g_num_cores               = 0;
+
+/* Way quota of each core, the same in every set. UCP partitions between
+ * cores 0 and 1; further cores keep the share they get at startup. */
+static UInt8  g_way_quota[MAX_ASSOCIATIVITY];
+static UInt64 g_wayQuotaStat[2];
+
+/* DAAIP. Every max_value fills of a core that evicted a block close its
+ * window: if db_threshold or more of the blocks it evicted were never hit,
+ * the core inserts at rrip_max for the next window, otherwise at
+ * rrip_insert. DBPV_DYN lets only one core be at rrip_max so that somebody
+ * uses the cache; here a core at rrip_max only cycles through its own
+ * quota, so every core decides on its own window (DAAIPInsertion without
+ * one_core_at_max).
+ */
+static UInt64 g_windowFills[2];
+static UInt64 g_windowDead[2];
+static UInt8  g_insert[2];
+static UInt64 g_insertStat[2];
+
+static StatCounter g_numTotalDeadBlocks[2];
+static StatCounter g_numTotalBlocksIns[2];
+static StatCounter g_numBlocksInvalid;
+static StatCounter g_numQuotaEvictions;   /* Victims taken from a core over its quota */
+static StatCounter g_numTouchedSets;
+
+/* UCP monitors. One in every (sets / srrip/ucp_monitor_sets) sets keeps the
+ * recency order of its ways next to the RRPVs and counts the hits at every
+ * recency position, weighted by the sampling stride; 0 monitors every
+ * set. At the end of every srrip/ucp_epoch_cycles cycles the split that
+ * maximizes the hits of the two cores becomes the new quota, and the
+ * monitors are shifted right by srrip/ucp_decay_shift.
+ */
+static UInt64 g_ucpRecency[2][MAX_ASSOCIATIVITY];
+static UInt64 g_ucpAccess[2];
+static UInt64 g_ucpEpochs               = 0;
+static UInt64 g_ucp_epoch_length        = 0;
+static UInt64 g_ucp_next_epoch          = 0;
+static UInt32 g_ucp_decay_shift         = 1;
+static UInt32 g_ucp_min_ways            = 1;
+static UInt32 g_ucp_stride              = 1;
+
+static void UCPpartition(UInt32 associativity)
+{
+    UInt64 hits[2][MAX_ASSOCIATIVITY + 1];
+    UInt32 best;
+
+    UCPcumulativeHits(g_ucpRecency[0], associativity, hits[0]);
+    UCPcumulativeHits(g_ucpRecency[1], associativity, hits[1]);
+
+    best = UCPbestSplit(hits[0], hits[1], associativity, g_ucp_min_ways, NULL);
+
+    g_way_quota[0] = best;
+    g_way_quota[1] = associativity - best;
+    g_wayQuotaStat[0] = g_way_quota[0];
+    g_wayQuotaStat[1] = g_way_quota[1];
+
+    printf("\n[Newton] DAAIP_UCP epoch:%lu Ways C0:%u C1:%u Hits:%lu Accesses C0:%lu C1:%lu\n",
+           g_ucpEpochs, g_way_quota[0], g_way_quota[1], hits[0][best] + hits[1][g_way_quota[1]],
+           g_ucpAccess[0], g_ucpAccess[1]);
+}
+
+static SInt64 DAAIPUCPperiodicCallback(UInt64 arg, UInt64 time)
+{
+    if (g_cycles_count < g_ucp_next_epoch)
+    {
+        return 0;
+    }
+
+    g_ucpEpochs++;
+
+    if (g_num_cores > 1)
+    {
+        UCPpartition(g_way_quota[0] + g_way_quota[1]);
+    }
+
+    for (UInt32 c = 0; c < 2; c++)
+    {
+        for (UInt32 i = 0; i < MAX_ASSOCIATIVITY; i++)
+        {
+            g_ucpRecency[c][i] >>= g_ucp_decay_shift;
+        }
+
+        g_ucpAccess[c] >>= g_ucp_decay_shift;
+    }
+
+    g_ucp_next_epoch = (g_cycles_count / g_ucp_epoch_length + 1) * g_ucp_epoch_length;
+
+    return 0;
+}
+
+/* Demand fill of core that evicted a block; the dead victims were already
+ * counted for the cores that owned them */
+static void WindowFill(UInt32 core, UInt32 window, UInt32 db_percent_threshold,
+                       UInt8 rrip_max, UInt8 rrip_insert)
+{
+    UInt32 db_percent;
+
+    if (!DAAIPWindowFill(g_windowFills[core], g_windowDead[core], window, db_percent))
+    {
+        return;
+    }
+
+    g_insert[core]     = DAAIPInsertion(db_percent >= db_percent_threshold, g_insert[1 - core],
+                                        rrip_max, rrip_insert, false);
+    g_insertStat[core] = g_insert[core];
+
+    printf("\n[Newton] DAAIP_UCP C%u DB_Percent:%u InsertedAt:%u Ways:%u\n",
+           core, db_percent, g_insert[core], g_way_quota[core]);
+}
+
+CacheSetDAAIP_UCP::CacheSetDAAIP_UCP(
+      String cfgname, core_id_t core_id,
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize, CacheSetInfoLRU* set_info, UInt8 num_attempts)
+   : CacheSet(cache_type, associativity, blocksize)
+   , m_params(SRRIPParams::get(cfgname, core_id, associativity, num_attempts, SRRIPParams::NEEDS_DEADBLOCK))
+   , m_meta(NULL)   /* Allocated on first touch of the set */
+   , m_ucp_weight(0)
+   , m_replacement_pointer(0)
+   , m_set_info(set_info)
+{
+    static UInt32 setID = 0;
+
+    LOG_ASSERT_ERROR(m_associativity <= MAX_ASSOCIATIVITY, "DAAIP_UCP supports up to %u ways", MAX_ASSOCIATIVITY);
+
+    if (0 == g_iteration_count)
+    {
+        g_iteration_count++;
+
+        config::Config *cfg = Sim()->getCfg();
+
+        g_num_cores = cfg->getInt("general/total_cores");
+        LOG_ASSERT_ERROR(g_num_cores <= m_associativity, "DAAIP_UCP needs at least one way per core");
+
+        g_ucp_epoch_length = cfg->getIntDefault(cfgname + "/srrip/ucp_epoch_cycles", 1000000);
+        g_ucp_next_epoch   = g_ucp_epoch_length;
+        g_ucp_decay_shift  = cfg->getIntDefault(cfgname + "/srrip/ucp_decay_shift", 1);
+        g_ucp_min_ways     = cfg->getIntDefault(cfgname + "/srrip/ucp_min_ways", 1);
+        LOG_ASSERT_ERROR((g_ucp_min_ways >= 1) && (2 * g_ucp_min_ways <= m_associativity),
+                         "srrip/ucp_min_ways must leave at least one way to each core");
+
+        /* cache_size is in KB */
+        {
+            UInt64 num_sets     = (UInt64)cfg->getInt(cfgname + "/cache_size") * 1024 / (associativity * blocksize);
+            UInt32 monitor_sets = cfg->getIntDefault(cfgname + "/srrip/ucp_monitor_sets", 0);
+
+            g_ucp_stride = ((monitor_sets > 0) && (monitor_sets < num_sets)) ? (num_sets / monitor_sets) : 1;
+        }
+
+        printf("\n[Newton] DAAIP_UCP with associativity:%d Counter Limit:%u DB Threshold:%u UMON Stride:%u Epoch:%lu!!!\n",
+               m_associativity, m_params->saturation_counter_max_value, m_params->db_percent_threshold,
+               g_ucp_stride, g_ucp_epoch_length);
+
+        g_insert[0] = g_insert[1] = m_params->rrip_insert;
+        g_insertStat[0] = g_insertStat[1] = m_params->rrip_insert;
+
+        /* Equal share of the ways for every core to begin with */
+        for (UInt32 i = 0; i < g_num_cores; i++)
+        {
+            g_way_quota[i] = m_associativity / g_num_cores + ((i < m_associativity % g_num_cores) ? 1 : 0);
+        }
+
+        g_wayQuotaStat[0] = g_way_quota[0];
+        g_wayQuotaStat[1] = (g_num_cores > 1) ? g_way_quota[1] : 0;
+
+        for (UInt32 c = 0; c < 2; c++)
+        {
+            g_numTotalDeadBlocks[c].registerMetric("interval_timer", core_id, String("totalBlocksDeadC") + itostr(c));
+            g_numTotalBlocksIns[c].registerMetric("interval_timer", core_id, String("totalBlocksInsC") + itostr(c));
+            registerStatsMetric("interval_timer", core_id, String("wayQuotaC") + itostr(c), &g_wayQuotaStat[c]);
+            registerStatsMetric("interval_timer", core_id, String("insertionC") + itostr(c), &g_insertStat[c]);
+        }
+
+        g_numBlocksInvalid.registerMetric("interval_timer", core_id, "InvalidBlocks");
+        g_numQuotaEvictions.registerMetric("interval_timer", core_id, "quotaEvictions");
+        g_numTouchedSets.registerMetric("interval_timer", core_id, "touchedSets");
+        registerStatsMetric("interval_timer", core_id, "ucpEpochs", &g_ucpEpochs);
+
+        Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, DAAIPUCPperiodicCallback, 0);
+    }
+
+    if (0 == (setID % g_ucp_stride))
+    {
+        m_ucp_weight = g_ucp_stride;
+    }
+
+    setID++;
+}
+
+CacheSetDAAIP_UCP::~CacheSetDAAIP_UCP()
+{
+   /* m_meta belongs to the arena */
+}
+
+/* First access to the set: no way has an owner yet, and the recency order
+ * of a monitor starts as the way order */
+void
+CacheSetDAAIP_UCP::AllocateMeta()
+{
+    m_meta = SetMetaArena::get(META_ARRAYS * m_associativity + g_num_cores)->allocate();
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        rripBits()[i]      = m_params->rrip_insert;
+        blockOwner()[i]    = OWNER_NONE;
+        stackPosition()[i] = i;
+    }
+
+    g_numTouchedSets++;
+}
+
+/* Hand way index over to core_id. Sniper does not tell the policy about
+ * invalidations, so a way invalidated by coherence stays counted for its
+ * old owner until it is refilled; at eviction time every way is valid and
+ * the counts are exact.
+ */
+void
+CacheSetDAAIP_UCP::setBlockOwner(UInt32 index, core_id_t core_id)
+{
+    UInt8 *owner = blockOwner();
+
+    if (OWNER_NONE != owner[index])
+    {
+        ownerCount()[owner[index]]--;
+    }
+
+    ownerCount()[core_id]++;
+    owner[index] = core_id;
+}
+
+void
+CacheSetDAAIP_UCP::moveToMRU(UInt32 index)
+{
+    UInt8 *stack = stackPosition();
+    UInt8  position = stack[index];
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        if (stack[i] < position)
+        {
+            stack[i]++;
+        }
+    }
+
+    stack[index] = 0;
+}
+
+/* The core furthest over its quota gives up a way. If no core is over its
+ * quota, the requesting core replaces one of its own ways, or any way of
+ * the set (g_num_cores) if it holds none. */
+UInt32
+CacheSetDAAIP_UCP::getVictimCore(core_id_t core_id) const
+{
+    const UInt8 *count = ownerCount();
+    UInt32 victim_core = g_num_cores;
+    SInt32 max_excess  = 0;
+
+    for (UInt32 i = 0; i < g_num_cores; i++)
+    {
+        SInt32 excess = (SInt32)count[i] - (SInt32)g_way_quota[i];
+
+        if (excess > max_excess)
+        {
+            max_excess  = excess;
+            victim_core = i;
+        }
+    }
+
+    if (victim_core < g_num_cores)
+    {
+        g_numQuotaEvictions++;
+        return victim_core;
+    }
+
+    return (count[core_id] > 0) ? (UInt32)core_id : g_num_cores;
+}
+
+/* SRRIP over the ways of victim_core only: the first way with the largest
+ * RRPV from the replacement pointer on is the victim, and the ways of the
+ * partition are aged by what it lacked to rrip_max. Same victim and RRPVs
+ * as the SRRIP rounds restricted to the partition, without the rounds;
+ * the other cores' ways keep their RRPVs. */
+UInt32
+CacheSetDAAIP_UCP::getVictimInPartition(UInt32 victim_core)
+{
+    UInt8 *rrip_bits   = rripBits();
+    const UInt8 *owner = blockOwner();
+    bool   whole_set   = (victim_core >= g_num_cores);
+    UInt32 victim      = m_associativity;
+    UInt8  max_rrpv    = 0;
+
+    for (UInt32 n = 0, i = m_replacement_pointer; n < m_associativity; n++, i = (i + 1 == m_associativity) ? 0 : i + 1)
+    {
+        if ((whole_set || (owner[i] == victim_core)) && ((victim == m_associativity) || (rrip_bits[i] > max_rrpv)))
+        {
+            victim   = i;
+            max_rrpv = rrip_bits[i];
+        }
+    }
+
+    LOG_ASSERT_ERROR(victim < m_associativity, "DAAIP_UCP: core %u holds no way of the set", victim_core);
+
+    if (max_rrpv < m_params->rrip_max)
+    {
+        UInt8 delta = m_params->rrip_max - max_rrpv;
+
+        for (UInt32 i = 0; i < m_associativity; i++)
+        {
+            if (whole_set || (owner[i] == victim_core))
+            {
+                rrip_bits[i] += delta;
+            }
+        }
+    }
+
+    return victim;
+}
+
+UInt32
+CacheSetDAAIP_UCP::getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id)
+{
+    UInt32 index = m_associativity;
+
+    LOG_ASSERT_ERROR((core_id >= 0) && ((UInt32)core_id < g_num_cores), "DAAIP_UCP: invalid core %d", core_id);
+
+    touchMeta();
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        if (!m_cache_block_info_array[i]->isValid())
+        {
+            index = i;
+            g_numBlocksInvalid++;
+            break;
+        }
+    }
+
+    if (index == m_associativity)
+    {
+        UInt8 owner;
+
+        index = getVictimInPartition(getVictimCore(core_id));
+        owner = blockOwner()[index];
+
+        LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate");
+
+        if ((owner < 2) && (0 == blockAccess()[index]))
+        {
+            g_numTotalDeadBlocks[owner]++;
+            g_windowDead[owner]++;
+        }
+
+        if (core_id < 2)
+        {
+            WindowFill(core_id, m_params->saturation_counter_max_value, m_params->db_percent_threshold,
+                       m_params->rrip_max, m_params->rrip_insert);
+        }
+
+        m_replacement_pointer = (index + 1) % m_associativity;
+    }
+
+    if (core_id < 2)
+    {
+        g_numTotalBlocksIns[core_id]++;
+        g_ucpAccess[core_id] += m_ucp_weight;
+    }
+
+    rripBits()[index]    = (core_id < 2) ? g_insert[core_id] : m_params->rrip_insert;
+    blockAccess()[index] = 0;
+    setBlockOwner(index, core_id);
+
+    /* A monitor assumes MRU insertion, whatever RRPV the block got */
+    if (m_ucp_weight)
+    {
+        moveToMRU(index);
+    }
+
+    return index;
+}
+
+void
+CacheSetDAAIP_UCP::updateReplacementIndex(UInt32 accessed_index)
+{
+    touchMeta();
+
+    UInt8 owner = blockOwner()[accessed_index];
+
+    blockAccess()[accessed_index] = 1;
+    rripBits()[accessed_index]    = 0;
+
+    if (m_ucp_weight && (owner < 2))
+    {
+        g_ucpRecency[owner][stackPosition()[accessed_index]] += m_ucp_weight;
+        g_ucpAccess[owner] += m_ucp_weight;
+        moveToMRU(accessed_index);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef CACHE_SET_DAAIP_UCP_H
+#define CACHE_SET_DAAIP_UCP_H
+
+#include "cache_set.h"
+#include "cache_set_lru.h"
+#include "cache_set_srrip_params.h"
+#include "cache_set_meta_arena.h"
+
+/* DAAIP and UCP in one policy. UCP decides how many ways every core gets,
+ * DAAIP how long the blocks of a core live in them: the victim is the
+ * SRRIP victim among the ways of the core furthest over its quota, and the
+ * filled block is inserted at the RRPV the dead-block window of its core
+ * picked. Both run on the same per-way arrays in one pass over the set.
+ */
+class CacheSetDAAIP_UCP : public CacheSet
+{
+   public:
+      CacheSetDAAIP_UCP(String cfgname, core_id_t core_id,
+            CacheBase::cache_t cache_type,
+            UInt32 associativity, UInt32 blocksize, CacheSetInfoLRU* set_info, UInt8 num_attempts);
+      ~CacheSetDAAIP_UCP();
+
+      UInt32 getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id);
+      void updateReplacementIndex(UInt32 accessed_index);
+
+
+   private:
+      UInt32 getVictimCore(core_id_t core_id) const;
+      UInt32 getVictimInPartition(UInt32 victim_core);
+      void   setBlockOwner(UInt32 index, core_id_t core_id);
+      void   moveToMRU(UInt32 index);
+
+      void AllocateMeta();
+
+      void touchMeta()
+      {
+         if (NULL == m_meta)
+         {
+            AllocateMeta();
+         }
+      }
+
+      /* Per-way arrays, packed in one arena chunk: RRPV, owner core, block
+       * was hit since its fill, and the UMON recency position (0 is MRU,
+       * kept on monitor sets only). The ways held by each core follow. */
+      enum { META_RRIP = 0, META_OWNER, META_ACCESS, META_STACK, META_ARRAYS };
+
+      UInt8* rripBits()      const { return m_meta + META_RRIP   * m_associativity; }
+      UInt8* blockOwner()    const { return m_meta + META_OWNER  * m_associativity; }
+      UInt8* blockAccess()   const { return m_meta + META_ACCESS * m_associativity; }
+      UInt8* stackPosition() const { return m_meta + META_STACK  * m_associativity; }
+      UInt8* ownerCount()    const { return m_meta + META_ARRAYS * m_associativity; }
+
+      const SRRIPParams *m_params;
+            UInt8 *m_meta;        /* NULL until the set is first touched */
+            UInt32 m_ucp_weight;  /* UMON weight of the set, 0 if not a monitor */
+            UInt8  m_replacement_pointer;
+      CacheSetInfoLRU* m_set_info;
+};
+
+#endif /* CACHE_SET_DAAIP_UCP_H */
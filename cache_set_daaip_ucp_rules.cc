@@ -0,0 +1,63 @@
+#include "cache_set_daaip_ucp_rules.h"
+
+bool DAAIPWindowFill(UInt64 &fills, UInt64 &dead, UInt64 window, UInt32 &db_percent)
+{
+    if (++fills < window)
+    {
+        return false;
+    }
+
+    db_percent = 10000 * dead / fills;
+    fills = 0;
+    dead  = 0;
+
+    return true;
+}
+
+UInt8 DAAIPInsertion(bool dead, UInt8 other_insert, UInt8 rrip_max, UInt8 rrip_insert,
+                     bool one_core_at_max)
+{
+    if (dead)
+    {
+        return (one_core_at_max && (other_insert == rrip_max)) ? rrip_insert : rrip_max;
+    }
+
+    return rrip_insert;
+}
+
+void UCPcumulativeHits(const UInt64 *recency, UInt32 associativity, UInt64 *hits)
+{
+    hits[0] = 0;
+
+    for (UInt32 i = 0; i < associativity; i++)
+    {
+        hits[i + 1] = hits[i] + recency[i];
+    }
+}
+
+UInt32 UCPbestSplit(const UInt64 *hits_c0, const UInt64 *hits_c1, UInt32 associativity,
+                    UInt32 min_ways, const double *score)
+{
+    UInt32 best = min_ways;
+
+    for (UInt32 w = min_ways + 1; w <= associativity - min_ways; w++)
+    {
+        bool better;
+
+        if (score)
+        {
+            better = score[w] > score[best];
+        }
+        else
+        {
+            better = (hits_c0[w] + hits_c1[associativity - w]) > (hits_c0[best] + hits_c1[associativity - best]);
+        }
+
+        if (better)
+        {
+            best = w;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,33 @@
+#ifndef CACHE_SET_DAAIP_UCP_RULES_H
+#define CACHE_SET_DAAIP_UCP_RULES_H
+
+#include "fixed_types.h"
+
+/* The decisions DBPV_DYN, DBASP and DAAIP_UCP share, so that the policies
+ * do not drift apart: the DAAIP dead-block window and insertion rule, and
+ * the UCP lookahead split of the ways between cores 0 and 1.
+ */
+
+/* Count a demand fill that evicted a block in a window of the given length.
+ * At the last fill of the window db_percent is set to the share of dead
+ * victims, in 1/100 percent, the window restarts and true is returned. */
+bool DAAIPWindowFill(UInt64 &fills, UInt64 &dead, UInt64 window, UInt32 &db_percent);
+
+/* Insertion RRPV of a core whose last window was dead (at or over the
+ * threshold) or not. With one_core_at_max a dead core inserts at
+ * rrip_insert anyway while the other core is at rrip_max, so that at least
+ * one of them is able to utilize the cache. */
+UInt8 DAAIPInsertion(bool dead, UInt8 other_insert, UInt8 rrip_max, UInt8 rrip_insert,
+                     bool one_core_at_max);
+
+/* UMON hits of a core with every number of ways: hits[w] is the sum of its
+ * first w recency counters, for w = 0..associativity */
+void UCPcumulativeHits(const UInt64 *recency, UInt32 associativity, UInt64 *hits);
+
+/* Ways of core 0 out of associativity, core 1 gets the rest, each keeping
+ * at least min_ways. The split with the highest score[w] wins, or with the
+ * most hits of both cores if score is NULL; ties go to the fewest ways. */
+UInt32 UCPbestSplit(const UInt64 *hits_c0, const UInt64 *hits_c1, UInt32 associativity,
+                    UInt32 min_ways, const double *score);
+
+#endif /* CACHE_SET_DAAIP_UCP_RULES_H */
@@ -4,6 +4,18 @@
 #include "log.h"
 #include "cache.h"
 #include "stats.h"
+#include "cache_set_stat_counter.h"
+#include "cache_set_timing.h"
+#include "cache_set_warming.h"
+#include "cache_set_way_mask.h"
+#include "cache_set_daaip_ucp_rules.h"
+#include "hooks_manager.h"
+#include "config.h"
+#include "core_manager.h"
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
 
 extern UInt64 g_instruction_count;
 extern UInt64 g_cycles_count;
@@ -17,19 +29,26 @@ extern UInt64 g_cycles_count;
 */
 
 #define MAX_BLOCK_COUNT                 1      //(2^1 - 1) 1 bit counter
-#define LARGEST_16_BIT_NUMBER           65535  //(2^16 - 1) 16 bit counter
-#define TOTAL_NUM_CACHE_BLOCKS          65536  // Number of cache blocks in 4BM cache
 #define DB_PERCENT_THRESHOLD_99         9999    
 #define DB_PERCENT_THRESHOLD_90         9000    
+#define MAX_ASSOCIATIVITY               64     // Largest set the recency counters can track
 
 static UInt8  g_iteration_count         = 0;
-static UInt64 g_numTotalDeadBlocksC0    = 0;
-static UInt64 g_numTotalBlocksInsC0     = 0;
-static UInt64 g_numTotalDeadBlocksC1    = 0;
-static UInt64 g_numTotalBlocksInsC1     = 0;
-static UInt64 g_numBlocksInvalid        = 0;
-static UInt64 g_numTotalBlocksHitC0     = 0;
-static UInt64 g_numTotalBlocksHitC1     = 0;
+/* Dead evictions, fills and hits by core; every core of the run has its
+ * own, cores are bounded by the associativity */
+static StatCounter g_numTotalDeadBlocks[MAX_ASSOCIATIVITY];
+static StatCounter g_numTotalBlocksIns[MAX_ASSOCIATIVITY];
+static StatCounter g_numTotalBlocksHit[MAX_ASSOCIATIVITY];
+static StatCounter g_numBlocksInvalid;
+
+/* Sharer-aware accounting (srrip/sharer_aware). Every block keeps the cores
+ * that filled or hit it. Hits are charged to the core that hits, in the
+ * UCP monitors too, not to the core that filled the block. A block hit by
+ * a second core becomes shared: it leaves its filler's way count and LRU
+ * order, so shared data is not evicted to enforce one core's quota. */
+static StatCounter g_numSharedBlocks;
+static StatCounter g_numSharedEvictions;
+static StatCounter g_numCrossCoreHits;
 
 /* I wanted to implement the UCP: Utility based cache partitioning algorithm.
  * As per my understanding of the algo, we need to define counters for 
@@ -42,16 +61,108 @@ static UInt64 g_numTotalBlocksHitC1     = 0;
  * stack. From the bits we can find which recency counter we need to increment.
  */ 
  
-/* 16 recency counters to track the recency counts. These counters are not
- * block based, but are application based. */
-static UInt64 g_recencyCounterC0[16];
-static UInt64 g_recencyCounterC1[16];
+/* One recency counter per way to track the recency counts. These counters
+ * are not block based, but are application based. */
+static StatCounter g_recencyCounterC0[MAX_ASSOCIATIVITY];
+static StatCounter g_recencyCounterC1[MAX_ASSOCIATIVITY];
+
+/* UCP monitors. Same events as the recency counters above, which stay
+ * cumulative for the stats, but these are shifted right by
+ * srrip/ucp_decay_shift at the end of every epoch so UCP follows phase
+ * changes. A shift of 0 gives the old cumulative behaviour.
+ *
+ * Repartitioning runs from the periodic hook once an epoch of
+ * srrip/ucp_epoch_cycles cycles (or srrip/ucp_epoch_instructions
+ * instructions, if set) has passed, not from the miss path. Every decision
+ * is logged to dbasp_ucp.log with its hit and utility curves.
+ */
+static UInt64 g_ucpRecencyC0[MAX_ASSOCIATIVITY];
+static UInt64 g_ucpRecencyC1[MAX_ASSOCIATIVITY];
+static UInt64 g_ucpAccessC0             = 0;
+static UInt64 g_ucpAccessC1             = 0;
+static UInt64 g_ucpEpochs               = 0;
+static UInt64 g_ucp_epoch_length        = 0;
+static UInt64 g_ucp_next_epoch          = 0;
+static bool   g_ucp_epoch_instructions  = false;
+static UInt32 g_ucp_decay_shift         = 1;
+static UInt32 g_ucp_associativity       = 0;
+static FILE  *g_ucp_log                 = NULL;
+
+static SInt64 UCPperiodicCallback(UInt64 arg, UInt64 time);
+static void UCPWarmingHandoff();
+
+/* Host timing of the policy calls (srrip/timing_sample), misses by the way
+ * the victim was found */
+enum
+{
+    MISS_PATH_WAYMASK_INVALID = 0,
+    MISS_PATH_WAYMASK,
+    MISS_PATH_INVALID,
+    MISS_PATH_PARTITION,
+    NUM_MISS_PATHS
+};
+
+static const char * const g_missPathNames[NUM_MISS_PATHS] = { "waymask-invalid", "waymask", "invalid", "partition" };
+static const char * const g_hitPathNames[1]   = { "hit" };
+static const char * const g_epochPathNames[1] = { "epoch" };
+
+static PolicyTimer g_missTimer("DBASP", "miss", NUM_MISS_PATHS, g_missPathNames);
+static PolicyTimer g_hitTimer("DBASP", "hit", 1, g_hitPathNames);
+static PolicyTimer g_epochTimer("DBASP", "ucp", 1, g_epochPathNames);
+
+/* UCP objective (srrip/ucp_objective). "hits" maximizes the total number of
+ * hits, as in the UCP paper. The speedup objectives weight each core's
+ * marginal hits by its stall sensitivity. CPI of a core with w ways is
+ * estimated from the CPI it achieved with its current ways, plus
+ * srrip/ucp_miss_penalty cycles for every extra miss per instruction from
+ * the UMON curve. Its IPC with all ways stands in for IPC alone.
+ * srrip/ucp_min_ways is the QoS floor for every core, under any objective.
+ */
+#define UCP_OBJECTIVE_HITS              0
+#define UCP_OBJECTIVE_WEIGHTED_SPEEDUP  1
+#define UCP_OBJECTIVE_HARMONIC_SPEEDUP  2
+
+static UInt32 g_ucp_objective           = UCP_OBJECTIVE_HITS;
+static UInt32 g_ucp_min_ways            = 1;
+static UInt32 g_ucp_miss_penalty        = 200;
 
-/* These are 16 bit counters */
-static UInt32 g_ValidDeadBlocksC0    = 0;
-static UInt32 g_InsValidBlocksC0    = 0;
-static UInt32 g_ValidDeadBlocksC1    = 0;
-static UInt32 g_InsValidBlocksC1    = 0;
+/* Per-core instructions and elapsed cycles, decayed like the monitors */
+static UInt64 g_ucpInstructions[2];
+static UInt64 g_ucpCycles               = 0;
+static UInt64 g_ucp_last_instructions[2];
+static UInt64 g_ucp_last_cycles         = 0;
+
+/* Per-set behavior over the current UCP epoch (srrip/set_heatmap): misses,
+ * dead evictions and fills by core, indexed by set ID. Written to
+ * dbasp_heatmap.log at every epoch, then cleared.
+ *
+ * UMON sampling (srrip/ucp_monitor_sets = N, 0 monitors every set): only N
+ * sets feed the UCP monitors, each with weight sets / N so the curves keep
+ * the scale of a full monitor. All sets monitor until the first epoch,
+ * then the sets are chosen by srrip/ucp_monitor_select:
+ *   stride   every (sets / N)th set
+ *   heatmap  sets sorted by their misses of the last epoch, the median set
+ *            of each of N equal groups; redone every epoch, so the sample
+ *            spans hot and cold sets as the workload moves
+ */
+struct SetHeat
+{
+    UInt32 misses;
+    UInt32 dead;
+    UInt32 fills[2];
+};
+
+static std::vector<SetHeat> g_set_heat;
+static std::vector<UInt32>  g_ucp_weight;   /* Per set, 0 if not a monitor */
+static bool   g_heat_enabled             = false;
+static FILE  *g_heat_log                 = NULL;
+static UInt32 g_ucp_monitor_sets         = 0;
+static bool   g_ucp_monitor_heatmap      = false;
+static UInt64 g_ucp_num_monitors         = 0;
+
+/* 64 bit, large caches insert more blocks than a 16 bit count holds */
+static UInt64 g_ValidDeadBlocks[MAX_ASSOCIATIVITY];
+static UInt64 g_InsValidBlocks[MAX_ASSOCIATIVITY];
 
 static UInt8 g_core0_insert, g_core1_insert;
 
@@ -59,29 +170,124 @@ static UInt8  g_insertionCore0[1024];
 static UInt8  g_insertionCore1[1024];
 static UInt16 g_iteration = 0;
 
-static UInt8 ways_C0, ways_C1;
+/* Way quota of each core, the same in every set. Cores beyond the two that
+ * UCP partitions between keep the share they get at startup. */
+static UInt32 g_num_cores = 0;
+static UInt8  g_way_quota[MAX_ASSOCIATIVITY];
+
+/* Way-mask partitioning (srrip/partition_mode = waymask), like Intel CAT:
+ * a core only fills ways in its allocation mask; hits are allowed anywhere.
+ * Masks come from srrip/waymask_schedule when one is given, otherwise they
+ * follow the UCP quotas as contiguous way ranges. CacheSetDBASP::setWayMask
+ * reprograms a core at any time, e.g. from an external controller.
+ *
+ * Schedule format: "cycle:mask0,mask1,...;cycle:mask0,mask1,..."
+ */
+struct WayMaskUpdate
+{
+    UInt64 cycle;
+    std::vector<UInt64> masks;
+};
+
+static bool   g_waymask_mode = false;
+static UInt64 g_way_mask[MAX_ASSOCIATIVITY];
+static UInt64 g_all_ways_mask = 0;
+static UInt64 g_numWayMaskUpdates = 0;
+static std::vector<WayMaskUpdate> g_waymask_schedule;
+static UInt32 g_waymask_next = 0;
+
+static void setWayMasksFromQuota()
+{
+    UInt32 first_way = 0;
+
+    for (UInt32 i = 0; i < g_num_cores; i++)
+    {
+        CacheSetDBASP::setWayMask(i, allWaysMask(g_way_quota[i]) << first_way);
+        first_way += g_way_quota[i];
+    }
+}
+
+static void parseWayMaskSchedule(String schedule)
+{
+    const char *p = schedule.c_str();
+
+    while (*p)
+    {
+        WayMaskUpdate update;
+        char *end;
+
+        update.cycle = strtoull(p, &end, 0);
+        LOG_ASSERT_ERROR(':' == *end, "Bad srrip/waymask_schedule near \"%s\"", p);
+        p = end + 1;
+
+        do
+        {
+            update.masks.push_back(strtoull(p, &end, 0));
+            LOG_ASSERT_ERROR(end != p, "Bad srrip/waymask_schedule near \"%s\"", p);
+            p = (',' == *end) ? (end + 1) : end;
+        } while (',' == *end);
+
+        LOG_ASSERT_ERROR(update.masks.size() <= g_num_cores, "srrip/waymask_schedule has more masks than cores");
+        g_waymask_schedule.push_back(update);
+
+        p = (';' == *p) ? (p + 1) : p;
+    }
+}
+
+/* Apply every schedule entry whose cycle has been reached */
+static void applyWayMaskSchedule()
+{
+    while ((g_waymask_next < g_waymask_schedule.size())
+           && (g_cycles_count >= g_waymask_schedule[g_waymask_next].cycle))
+    {
+        const WayMaskUpdate &update = g_waymask_schedule[g_waymask_next++];
+
+        printf("\n[Newton] WayMask schedule @ %lu", g_cycles_count);
+        for (UInt32 i = 0; i < update.masks.size(); i++)
+        {
+            CacheSetDBASP::setWayMask(i, update.masks[i]);
+        }
+    }
+}
+
+void
+CacheSetDBASP::setWayMask(core_id_t core_id, UInt64 mask)
+{
+    if (((UInt32)core_id >= g_num_cores) || (0 == (mask & g_all_ways_mask)))
+    {
+        LOG_PRINT_WARNING("DBASP: ignoring way mask %#lx for core %d", mask, core_id);
+        return;
+    }
+
+    g_way_mask[core_id] = mask & g_all_ways_mask;
+    g_numWayMaskUpdates++;
+    printf("\n[Newton] WayMask C%d:%#lx", core_id, g_way_mask[core_id]);
+}
 
 CacheSetDBASP::CacheSetDBASP(
       String cfgname, core_id_t core_id,
       CacheBase::cache_t cache_type,
       UInt32 associativity, UInt32 blocksize, CacheSetInfoLRU* set_info, UInt8 num_attempts)
    : CacheSet(cache_type, associativity, blocksize)
-   , m_saturation_counter_max_value(Sim()->getCfg()->getIntArray(cfgname + "/srrip/max_value", core_id))
-   , m_db_percent_threshold(Sim()->getCfg()->getIntArray(cfgname + "/srrip/db_threshold", core_id))
-   , m_rrip_numbits(Sim()->getCfg()->getIntArray(cfgname + "/srrip/bits", core_id))
-   , m_rrip_max((1 << m_rrip_numbits) - 1)
-   , m_rrip_insert(m_rrip_max - 1)
+   , m_params(SRRIPParams::get(cfgname, core_id, associativity, num_attempts, SRRIPParams::NEEDS_DEADBLOCK))
    , m_replacement_pointer(0)
+   , m_recency(associativity)
    , m_set_info(set_info)
 {
    static UInt32 setID = 0;
    
    m_setID = setID++;
-   
-   m_rrip_bits = new UInt8[m_associativity];
-   for (UInt32 i = 0; i < m_associativity; i++)
-      m_rrip_bits[i] = m_rrip_insert + 5; //Invalid rrip
 
+   g_set_heat.push_back(SetHeat());
+   g_ucp_weight.push_back(1);
+
+   LOG_ASSERT_ERROR(m_associativity <= MAX_ASSOCIATIVITY, "DBASP supports up to %u ways", MAX_ASSOCIATIVITY);
+
+   if (m_params->lockstep_check)
+   {
+      m_recency.enableLockstep();
+   }
+   
     /* To record how many times a block got hit */
     m_block_access = new UInt8[m_associativity];
     for (UInt8 i = 0; i < m_associativity; i++)
@@ -91,50 +297,156 @@ CacheSetDBASP::CacheSetDBASP(
     
     /* To record which core brought the block into cache */
     m_block_owner = new UInt8[m_associativity];
+    m_block_sharers = new UInt8[m_associativity];
     for (UInt8 i = 0; i < m_associativity; i++)
     {
-        m_block_owner[i] = 0;
+        m_block_owner[i] = RecencyStack::OWNER_NONE;
+        m_block_sharers[i] = 0;
     }
 
     if (0 == g_iteration_count)
     {
         g_iteration_count++;
 
+        g_num_cores = Sim()->getCfg()->getInt("general/total_cores");
+        LOG_ASSERT_ERROR(g_num_cores <= m_associativity, "DBASP needs at least one way per core");
+
         printf("\n[Newton] DBASP with associativity:%d Counter Limit:%u DB Threshold:%u!!!\n",
-                m_associativity, m_saturation_counter_max_value, m_db_percent_threshold);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksDeadC0", &g_numTotalDeadBlocksC0);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksInsC0",  &g_numTotalBlocksInsC0);
+                m_associativity, m_params->saturation_counter_max_value, m_params->db_percent_threshold);
+
+        if (m_params->lockstep_check)
+        {
+            printf("[Newton] Lockstep check of the recency stack and partition victims enabled\n");
+        }
+        for (UInt32 c = 0; c < g_num_cores; c++)
+        {
+            g_numTotalDeadBlocks[c].registerMetric("interval_timer", core_id, String("totalBlocksDeadC") + itostr(c));
+            g_numTotalBlocksIns[c].registerMetric("interval_timer", core_id, String("totalBlocksInsC") + itostr(c));
+            g_numTotalBlocksHit[c].registerMetric("interval_timer", core_id, String("totalBlocksHitC") + itostr(c));
+        }
 
-        registerStatsMetric("interval_timer", core_id, "totalBlocksDeadC1", &g_numTotalDeadBlocksC1);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksInsC1",  &g_numTotalBlocksInsC1);
 
-        registerStatsMetric("interval_timer", core_id, "totalBlocksHitC0",  &g_numTotalBlocksHitC0);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksHitC1",  &g_numTotalBlocksHitC1);
+        g_numBlocksInvalid.registerMetric("interval_timer", core_id, "InvalidBlocks");
 
+        if (m_params->fast_warming)
+        {
+            printf("[Newton] DBASP fast warming enabled\n");
+            PolicyWarming::enable(UCPWarmingHandoff);
+        }
 
-        registerStatsMetric("interval_timer", core_id, "InvalidBlocks",     &g_numBlocksInvalid);
+        if (m_params->sharer_aware)
+        {
+            printf("[Newton] Sharer-aware accounting enabled\n");
+            g_numSharedBlocks.registerMetric("interval_timer", core_id, "sharedBlocks");
+            g_numSharedEvictions.registerMetric("interval_timer", core_id, "sharedEvictions");
+            g_numCrossCoreHits.registerMetric("interval_timer", core_id, "crossCoreHits");
+        }
         
         /* Initialize the insertion locations: MRU position */
-        g_core0_insert = m_rrip_insert;
-        g_core1_insert = m_rrip_insert;
+        g_core0_insert = m_params->rrip_insert;
+        g_core1_insert = m_params->rrip_insert;
 
-        ways_C1 = ways_C0 = m_associativity/2;
+        /* Equal share of the ways for every core to begin with */
+        for (UInt32 i = 0; i < g_num_cores; i++)
+        {
+            g_way_quota[i] = m_associativity / g_num_cores + ((i < m_associativity % g_num_cores) ? 1 : 0);
+        }
+
+        g_all_ways_mask = allWaysMask(m_associativity);
+        g_waymask_mode  = ("waymask" == Sim()->getCfg()->getStringDefault(cfgname + "/srrip/partition_mode", "quota"));
+
+        {
+            UInt64 epoch_instructions = Sim()->getCfg()->getIntDefault(cfgname + "/srrip/ucp_epoch_instructions", 0);
+
+            g_ucp_epoch_instructions = (epoch_instructions > 0);
+            g_ucp_epoch_length = g_ucp_epoch_instructions ? epoch_instructions
+                               : Sim()->getCfg()->getIntDefault(cfgname + "/srrip/ucp_epoch_cycles", 1000000);
+            g_ucp_next_epoch   = g_ucp_epoch_length;
+            g_ucp_decay_shift  = Sim()->getCfg()->getIntDefault(cfgname + "/srrip/ucp_decay_shift", 1);
+            g_ucp_associativity = m_associativity;
+
+            String objective = Sim()->getCfg()->getStringDefault(cfgname + "/srrip/ucp_objective", "hits");
+
+            if ("weighted_speedup" == objective)
+                g_ucp_objective = UCP_OBJECTIVE_WEIGHTED_SPEEDUP;
+            else if ("harmonic_speedup" == objective)
+                g_ucp_objective = UCP_OBJECTIVE_HARMONIC_SPEEDUP;
+            else if ("hits" == objective)
+                g_ucp_objective = UCP_OBJECTIVE_HITS;
+            else
+                LOG_PRINT_ERROR("Unknown srrip/ucp_objective %s", objective.c_str());
+
+            g_ucp_min_ways     = Sim()->getCfg()->getIntDefault(cfgname + "/srrip/ucp_min_ways", 1);
+            g_ucp_miss_penalty = Sim()->getCfg()->getIntDefault(cfgname + "/srrip/ucp_miss_penalty", 200);
+            LOG_ASSERT_ERROR((g_ucp_min_ways >= 1) && (2 * g_ucp_min_ways <= m_associativity),
+                             "srrip/ucp_min_ways must leave at least one way to each core");
+            g_ucp_log = fopen(Sim()->getConfig()->formatOutputFileName("dbasp_ucp.log").c_str(), "w");
+
+            g_ucp_monitor_sets    = Sim()->getCfg()->getIntDefault(cfgname + "/srrip/ucp_monitor_sets", 0);
+            String select         = Sim()->getCfg()->getStringDefault(cfgname + "/srrip/ucp_monitor_select", "stride");
+            g_ucp_monitor_heatmap = ("heatmap" == select);
+            LOG_ASSERT_ERROR(g_ucp_monitor_heatmap || ("stride" == select), "Unknown srrip/ucp_monitor_select %s", select.c_str());
+
+            g_heat_enabled = Sim()->getCfg()->getBoolDefault(cfgname + "/srrip/set_heatmap", false);
+
+            if (g_heat_enabled)
+            {
+                g_heat_log = fopen(Sim()->getConfig()->formatOutputFileName("dbasp_heatmap.log").c_str(), "w");
+            }
+
+            /* Heatmap selection ranks the sets by their counters */
+            g_heat_enabled |= (g_ucp_monitor_sets > 0) && g_ucp_monitor_heatmap;
+
+            if (g_ucp_monitor_sets)
+            {
+                printf("[Newton] UMON sampling, Sets:%u Select:%s\n", g_ucp_monitor_sets, select.c_str());
+            }
+
+            Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, UCPperiodicCallback, 0);
+            registerStatsMetric("interval_timer", core_id, "ucpEpochs", &g_ucpEpochs);
+            registerStatsMetric("interval_timer", core_id, "ucpMonitorSets", &g_ucp_num_monitors);
+        }
+
+        if (g_waymask_mode)
+        {
+            setWayMasksFromQuota();
+            parseWayMaskSchedule(Sim()->getCfg()->getStringDefault(cfgname + "/srrip/waymask_schedule", ""));
+            applyWayMaskSchedule();
+            registerStatsMetric("interval_timer", core_id, "wayMaskUpdates", &g_numWayMaskUpdates);
+        }
         
        for(UInt32 i = 0; i < m_associativity; i++)
        {
-          g_recencyCounterC0[i] = 0;
-          registerStatsMetric("interval_timer", core_id,
-                              String("recencyCounterC0-")+itostr(i), &g_recencyCounterC0[i]);
+          g_recencyCounterC0[i].registerMetric("interval_timer", core_id, String("recencyCounterC0-")+itostr(i));
 
-          registerStatsMetric("interval_timer", core_id,
-                              String("recencyCounterC1-")+itostr(i), &g_recencyCounterC1[i]);
+          g_recencyCounterC1[i].registerMetric("interval_timer", core_id, String("recencyCounterC1-")+itostr(i));
        }
+
+        if (m_params->timing_sample)
+        {
+            printf("[Newton] Policy call timing, Sample:1/%u\n", m_params->timing_sample);
+            PolicyTimer::setSampling(m_params->timing_sample);
+            g_missTimer.registerMetrics(core_id);
+            g_hitTimer.registerMetrics(core_id);
+            g_epochTimer.registerMetrics(core_id);
+        }
+    }
+
+    /* Number of ways each core holds in this set, kept up to date on every
+     * fill so partition enforcement does not have to scan the set */
+    m_owner_count = new UInt8[g_num_cores];
+    for (UInt32 i = 0; i < g_num_cores; i++)
+    {
+        m_owner_count[i] = 0;
     }
 }
 
 CacheSetDBASP::~CacheSetDBASP()
 {
-   delete [] m_rrip_bits;
+   delete [] m_block_access;
+   delete [] m_block_owner;
+   delete [] m_block_sharers;
+   delete [] m_owner_count;
    
    for (UInt32 i = 0; i < g_iteration; i++)
    {
@@ -142,166 +454,407 @@ CacheSetDBASP::~CacheSetDBASP()
    }
 }
 
-static void UCPpartition()
+static double estimateCPI(double cpi_now, int extra_misses, double instructions)
 {
-    int associativity = 16;
- 
-    int totalAccessC0 = g_numTotalBlocksInsC0 + g_numTotalBlocksHitC0;
-    int totalAccessC1 = g_numTotalBlocksInsC1 + g_numTotalBlocksHitC1;
-
-    int miss_c0[17];
-    int miss_c1[17];
-    int hit_c0[17];
-    int hit_c1[17];
-    int utility[17];
-    int hit0, hit1, i, j, max, max_i;
-    
+    double cpi = cpi_now + (double)extra_misses * g_ucp_miss_penalty / instructions;
+
+    /* Never estimate better than a 4-wide core */
+    return (cpi < 0.25) ? 0.25 : cpi;
+}
+
+static void UCPpartition(int associativity)
+{
+    int totalAccessC0 = g_ucpAccessC0;
+    int totalAccessC1 = g_ucpAccessC1;
+
+    int miss_c0[MAX_ASSOCIATIVITY + 1];
+    int miss_c1[MAX_ASSOCIATIVITY + 1];
+    UInt64 hit_c0[MAX_ASSOCIATIVITY + 1];
+    UInt64 hit_c1[MAX_ASSOCIATIVITY + 1];
+    int utility[MAX_ASSOCIATIVITY + 1];
+    int i, j, max_i;
+    double score[MAX_ASSOCIATIVITY + 1];
+    double cpi_now[2], ipc_est[2];
+
+    UCPcumulativeHits(g_ucpRecencyC0, associativity, hit_c0);
+    UCPcumulativeHits(g_ucpRecencyC1, associativity, hit_c1);
+
     miss_c0[0] = totalAccessC0;
     miss_c1[0] = totalAccessC1;
 
-    hit0 = hit1 = 0;
-    
     for (i = 0; i < associativity; i++)
     {
-        hit0 += g_recencyCounterC0[i];
-        hit1 += g_recencyCounterC1[i];
-        
-        hit_c0[i+1] = hit0;
-        hit_c1[i+1] = hit1;
-
-        /* miss_c0[1]  contains misses when 1  way is   given, similarly
-         * miss_c0[16] contains misses when 16 ways are given */
+        /* miss_c0[1] contains misses when 1 way is given, similarly
+         * miss_c0[associativity] contains misses when all ways are given */
 
-        miss_c0[i+1] = totalAccessC0 - hit_c0[i+1];
-        miss_c1[i+1] = totalAccessC1 - hit_c1[i+1];
+        miss_c0[i+1] = totalAccessC0 - (int)hit_c0[i+1];
+        miss_c1[i+1] = totalAccessC1 - (int)hit_c1[i+1];
         
-        printf("\ni=%d totalAccC0:%d totalAccC1:%d hitC0:%d hitC1:%d missC0=%d missC1=%d", i+1, totalAccessC0, totalAccessC1, hit_c0[i+1], hit_c1[i+1], miss_c0[i+1], miss_c1[i+1]);
+        printf("\ni=%d totalAccC0:%d totalAccC1:%d hitC0:%lu hitC1:%lu missC0=%d missC1=%d", i+1, totalAccessC0, totalAccessC1, hit_c0[i+1], hit_c1[i+1], miss_c0[i+1], miss_c1[i+1]);
     }
 
     /* Recording utility for each combination of way distribution */
     for (j = 1; j < associativity; j++)
     {
-        utility[j] = (miss_c0[0] - miss_c0[j]) + (miss_c1[0] - miss_c1[16-j]);
-        printf("\nj:%d Util:%d C0: miss0:%d missj:%d C1: miss0:%d missj:%d", j, utility[j], miss_c0[0], miss_c0[j], miss_c1[0], miss_c1[16-j]);
+        utility[j] = (miss_c0[0] - miss_c0[j]) + (miss_c1[0] - miss_c1[associativity-j]);
+        printf("\nj:%d Util:%d C0: miss0:%d missj:%d C1: miss0:%d missj:%d", j, utility[j], miss_c0[0], miss_c0[j], miss_c1[0], miss_c1[associativity-j]);
     }
 
-    max = utility[1];
-    max_i = 1;
- 
-    /* We need to find the maximum utility */
-    for (i = 2; i < associativity; i++)
+    /* Current CPI of each core over the monitored window */
+    for (i = 0; i < 2; i++)
+    {
+        cpi_now[i] = g_ucpInstructions[i] ? ((double)g_ucpCycles / g_ucpInstructions[i]) : 1.0;
+    }
+
+    if (UCP_OBJECTIVE_HITS != g_ucp_objective)
     {
-        if (utility[i] > max)
+        int    cur0 = g_way_quota[0];
+        int    cur1 = g_way_quota[1];
+        double inst0 = g_ucpInstructions[0] ? g_ucpInstructions[0] : 1;
+        double inst1 = g_ucpInstructions[1] ? g_ucpInstructions[1] : 1;
+        double alone0 = estimateCPI(cpi_now[0], miss_c0[associativity] - miss_c0[cur0], inst0);
+        double alone1 = estimateCPI(cpi_now[1], miss_c1[associativity] - miss_c1[cur1], inst1);
+
+        for (j = 1; j < associativity; j++)
         {
-            max_i = i;
-            max = utility[i];
-            printf("\nMax_i:%d maxUtil:%d", max_i, max);
+            double cpi0 = estimateCPI(cpi_now[0], miss_c0[j] - miss_c0[cur0], inst0);
+            double cpi1 = estimateCPI(cpi_now[1], miss_c1[associativity-j] - miss_c1[cur1], inst1);
+
+            /* Speedup of a core relative to running alone is CPI_alone / CPI */
+            if (UCP_OBJECTIVE_WEIGHTED_SPEEDUP == g_ucp_objective)
+            {
+                score[j] = alone0 / cpi0 + alone1 / cpi1;
+            }
+            else
+            {
+                score[j] = 2.0 / (cpi0 / alone0 + cpi1 / alone1);
+            }
         }
     }
-    
-    printf("\nMax_i:%d maxUtil:%d\n", max_i, max);
 
-    ways_C0 = max_i;
-    ways_C1 = associativity - ways_C0;
-    printf("\n[Newton] Utility Changed C0:%u, C1:%u", ways_C0, ways_C1);
+    /* We need to find the maximum utility, within the QoS floor of each core */
+    max_i = UCPbestSplit(hit_c0, hit_c1, associativity, g_ucp_min_ways,
+                         (UCP_OBJECTIVE_HITS == g_ucp_objective) ? NULL : score);
+
+    printf("\nMax_i:%d maxUtil:%d\n", max_i, utility[max_i]);
+
+    /* Estimated IPC of each core with its new ways */
+    ipc_est[0] = 1.0 / estimateCPI(cpi_now[0], miss_c0[max_i] - miss_c0[g_way_quota[0]],
+                                   g_ucpInstructions[0] ? g_ucpInstructions[0] : 1);
+    ipc_est[1] = 1.0 / estimateCPI(cpi_now[1], miss_c1[associativity-max_i] - miss_c1[g_way_quota[1]],
+                                   g_ucpInstructions[1] ? g_ucpInstructions[1] : 1);
+
+    printf("\n[Newton] UCP IPC C0:%.3f->%.3f C1:%.3f->%.3f", 1.0 / cpi_now[0], ipc_est[0],
+           1.0 / cpi_now[1], ipc_est[1]);
+
+    g_way_quota[0] = max_i;
+    g_way_quota[1] = associativity - max_i;
+    printf("\n[Newton] Utility Changed C0:%u, C1:%u", g_way_quota[0], g_way_quota[1]);
+
+    if (g_ucp_log)
+    {
+        fprintf(g_ucp_log, "epoch=%lu cycles=%lu instructions=%lu ways=%u,%u accesses=%d,%d",
+                g_ucpEpochs, g_cycles_count, g_instruction_count,
+                g_way_quota[0], g_way_quota[1], totalAccessC0, totalAccessC1);
+
+        fprintf(g_ucp_log, " ipc=%.4f,%.4f ipc_est=%.4f,%.4f",
+                1.0 / cpi_now[0], 1.0 / cpi_now[1], ipc_est[0], ipc_est[1]);
+
+        fprintf(g_ucp_log, " hitsC0=");
+        for (i = 1; i <= associativity; i++)
+            fprintf(g_ucp_log, "%s%lu", (i > 1) ? "," : "", hit_c0[i]);
+
+        fprintf(g_ucp_log, " hitsC1=");
+        for (i = 1; i <= associativity; i++)
+            fprintf(g_ucp_log, "%s%lu", (i > 1) ? "," : "", hit_c1[i]);
+
+        fprintf(g_ucp_log, " utility=");
+        for (j = 1; j < associativity; j++)
+            fprintf(g_ucp_log, "%s%d", (j > 1) ? "," : "", utility[j]);
+
+        fprintf(g_ucp_log, "\n");
+    }
 }
 
-static UInt32 getLRUCandidate(UInt32 *pArr, UInt32 entries)
+static bool hotterSet(UInt32 a, UInt32 b)
 {
-    UInt32 max = pArr[0];
-    UInt32 max_i = 0, i;
- 
-    //#if 0
-    printf("\n");
-    for (i = 0; i < entries; i++)
+    if (g_set_heat[a].misses != g_set_heat[b].misses)
+        return g_set_heat[a].misses < g_set_heat[b].misses;
+
+    if (g_set_heat[a].dead != g_set_heat[b].dead)
+        return g_set_heat[a].dead < g_set_heat[b].dead;
+
+    return a < b;
+}
+
+static void UCPselectMonitors()
+{
+    UInt32 num_sets = g_ucp_weight.size();
+    UInt32 monitors = (g_ucp_monitor_sets < num_sets) ? g_ucp_monitor_sets : num_sets;
+    UInt32 weight   = num_sets / monitors;
+
+    std::fill(g_ucp_weight.begin(), g_ucp_weight.end(), 0);
+
+    if (g_ucp_monitor_heatmap)
+    {
+        std::vector<UInt32> order(num_sets);
+
+        for (UInt32 i = 0; i < num_sets; i++)
+            order[i] = i;
+
+        std::sort(order.begin(), order.end(), hotterSet);
+
+        for (UInt32 k = 0; k < monitors; k++)
+            g_ucp_weight[order[(UInt64(2 * k + 1) * num_sets) / (2 * monitors)]] = weight;
+    }
+    else
     {
-        printf("%u:%u  ",i,pArr[i]);
+        for (UInt32 k = 0; k < monitors; k++)
+            g_ucp_weight[k * weight] = weight;
     }
-    printf("\n");
-    //#endif
- 
-    /* We need to find the maximum utility */
-    for (i = 1; i < entries; i++)
+
+    g_ucp_num_monitors = monitors;
+
+    if (g_heat_log)
     {
-        //printf("\n%u:%u  ",i,pArr[i]);
-        if (pArr[i] > max)
+        fprintf(g_heat_log, "epoch=%lu monitors=", g_ucpEpochs);
+
+        for (UInt32 i = 0, n = 0; i < num_sets; i++)
+            if (g_ucp_weight[i])
+                fprintf(g_heat_log, "%s%u", (n++ > 0) ? "," : "", i);
+
+        fprintf(g_heat_log, " weight=%u\n", weight);
+    }
+}
+
+static void writeSetHeatmap()
+{
+    const char *names[4] = { "misses", "dead", "fillsC0", "fillsC1" };
+
+    fprintf(g_heat_log, "epoch=%lu cycles=%lu", g_ucpEpochs, g_cycles_count);
+
+    for (UInt32 m = 0; m < 4; m++)
+    {
+        fprintf(g_heat_log, " %s=", names[m]);
+
+        for (UInt32 i = 0; i < g_set_heat.size(); i++)
         {
-            max_i = i;
-            max = pArr[i];
-            printf("\nMax_i:%d maxUtil:%d\n", max_i, max);
+            const SetHeat &heat = g_set_heat[i];
+            UInt32 value = (0 == m) ? heat.misses : (1 == m) ? heat.dead : heat.fills[m - 2];
+
+            fprintf(g_heat_log, "%s%u", (i > 0) ? "," : "", value);
         }
     }
-    
-    printf("\nnumEntries:%u Max_i:%d maxUtil:%d\n", entries, max_i, max);
-    
-    return max_i;
+
+    fprintf(g_heat_log, "\n");
 }
 
+/* End of a UCP epoch: repartition, then age the monitors */
+static void UCPepoch()
+{
+    UInt64 tsc = PolicyTimer::start();
+
+    g_ucpEpochs++;
+    printf("\n[Newton] UCP called %lu times @ %lu", g_ucpEpochs, g_cycles_count);
 
-/* when the block will be inserted at MRU position, all the blocks will
- * shift in the LRU recency stack by one
- */
-static void insertBlockToNearToLRUposition(UInt32 uiIndex, UInt8 *p_rrip_bits,
-                                    UInt32 associativity, UInt32 rrpv)
+    /* Instructions of each core and cycles in this epoch */
+    for (UInt32 i = 0; i < 2 && i < g_num_cores; i++)
+    {
+        UInt64 instructions = Sim()->getCoreManager()->getCoreFromID(i)->getInstructionCount();
+
+        g_ucpInstructions[i] += instructions - g_ucp_last_instructions[i];
+        g_ucp_last_instructions[i] = instructions;
+    }
+
+    g_ucpCycles += g_cycles_count - g_ucp_last_cycles;
+    g_ucp_last_cycles = g_cycles_count;
+
+    UCPpartition((g_num_cores > 1) ? (g_way_quota[0] + g_way_quota[1]) : g_ucp_associativity);
+
+    /* Without a schedule, the masks follow the new UCP quotas */
+    if (g_waymask_mode && g_waymask_schedule.empty())
+    {
+        setWayMasksFromQuota();
+    }
+
+    if (g_heat_log)
+    {
+        writeSetHeatmap();
+    }
+
+    /* Stride sets are chosen once, heatmap sets from every epoch's heatmap */
+    if (g_ucp_monitor_sets && (g_ucp_monitor_heatmap || (1 == g_ucpEpochs)))
+    {
+        UCPselectMonitors();
+    }
+
+    if (g_heat_enabled)
+    {
+        std::fill(g_set_heat.begin(), g_set_heat.end(), SetHeat());
+    }
+
+    for (UInt32 i = 0; i < g_ucp_associativity; i++)
+    {
+        g_ucpRecencyC0[i] >>= g_ucp_decay_shift;
+        g_ucpRecencyC1[i] >>= g_ucp_decay_shift;
+    }
+
+    g_ucpAccessC0 >>= g_ucp_decay_shift;
+    g_ucpAccessC1 >>= g_ucp_decay_shift;
+    g_ucpInstructions[0] >>= g_ucp_decay_shift;
+    g_ucpInstructions[1] >>= g_ucp_decay_shift;
+    g_ucpCycles >>= g_ucp_decay_shift;
+
+    g_epochTimer.stop(tsc, 0);
+}
+
+/* Switch from warming to detailed mode (srrip/fast_warming): the monitors
+ * and the set heatmap start empty, the first epoch ends one epoch length
+ * from now. The partition reached so far carries over. */
+static void UCPWarmingHandoff()
 {
-    /* To insert a block at (LRU - 1) position in the recency stack, we need to
-     * increment the recency of (LRU - 1) block to LRU and then insert the block
-     * at (LRU - 1)
-     */
-    for(UInt32 i = 0; i < associativity; i++)
+    UInt64 now = g_ucp_epoch_instructions ? g_instruction_count : g_cycles_count;
+
+    for (UInt32 i = 0; i < MAX_ASSOCIATIVITY; i++)
     {
-        /* Finding the block at (LRU - 1) and move it to LRU */
-        if (p_rrip_bits[i] == rrpv - 1)
-        {
-            p_rrip_bits[i]++;
+        g_ucpRecencyC0[i] = 0;
+        g_ucpRecencyC1[i] = 0;
+    }
 
-            /* I assume only one block/line to be at (LRU - 1) */
-            printf("\nDemoted Block@Index:%u to LRU\n", i);
-            break;
-        }
+    g_ucpAccessC0 = g_ucpAccessC1 = 0;
+    g_ucpInstructions[0] = g_ucpInstructions[1] = 0;
+    g_ucpCycles = 0;
+
+    for (UInt32 i = 0; i < 2 && i < g_num_cores; i++)
+    {
+        g_ucp_last_instructions[i] = Sim()->getCoreManager()->getCoreFromID(i)->getInstructionCount();
     }
 
-    p_rrip_bits[uiIndex] = rrpv - 1;
-   
-    //#if 0
-    for (UInt32 i = 0; i < associativity;  i++)
+    g_ucp_last_cycles = g_cycles_count;
+    g_ucp_next_epoch  = (now / g_ucp_epoch_length + 1) * g_ucp_epoch_length;
+
+    std::fill(g_set_heat.begin(), g_set_heat.end(), SetHeat());
+}
+
+static SInt64 UCPperiodicCallback(UInt64 arg, UInt64 time)
+{
+    UInt64 now = g_ucp_epoch_instructions ? g_instruction_count : g_cycles_count;
+
+    applyWayMaskSchedule();
+
+    /* No repartitioning while warming */
+    if (PolicyWarming::isWarming())
     {
-        printf("%u:%u  ", i, p_rrip_bits[i]);
-    } 
+        return 0;
+    }
 
-    printf("\nRecencyCtr\n");
-    for(UInt32 i = 0; i < associativity; i++)
+    if (now >= g_ucp_next_epoch)
     {
-       printf("%u:%lu  ", i, g_recencyCounterC0[i]); 
+        UCPepoch();
+        g_ucp_next_epoch = (now / g_ucp_epoch_length + 1) * g_ucp_epoch_length;
     }
-    //#endif
+
+    return 0;
 }
 
-/* when the block will be inserted at MRU position, all the blocks will
- * shift in the LRU recency stack by one
+/* Fills count as accesses of the UCP monitors, of cores 0 and 1 only */
+static void countUCPFill(core_id_t core_id, UInt32 weight)
+{
+    if (0 == core_id)
+    {
+        g_ucpAccessC0 += weight;
+    }
+    else if (1 == core_id)
+    {
+        g_ucpAccessC1 += weight;
+    }
+}
+
+/* A filled block goes one position above the block it replaced, the block
+ * there moves down into the freed position. For a global LRU victim this is
+ * the (LRU - 1) insertion; fills of invalid ways also go to (LRU - 1).
+ */
+static UInt32 getInsertionPosition(UInt32 victimPosition)
+{
+    return (victimPosition > 0) ? (victimPosition - 1) : 0;
+}
+
+/* Hand way index over to core_id. Sniper does not tell the policy about
+ * invalidations, so a way invalidated by coherence stays counted for its
+ * old owner until it is refilled; at eviction time every way is valid and
+ * the counts are exact.
  */
-static void insertBlockToMRUposition(UInt32 uiIndex, UInt8 *p_rrip_bits, UInt32 associativity)
+void
+CacheSetDBASP::setBlockOwner(UInt32 index, core_id_t core_id)
 {
-    for(UInt32 i = 0; i < associativity; i++)
+    LOG_ASSERT_ERROR((UInt32)core_id < g_num_cores, "DBASP: invalid core %d", core_id);
+
+    /* A shared block was already taken out of its filler's count */
+    if ((RecencyStack::OWNER_NONE != m_block_owner[index]) && !isShared(index))
     {
-        if (p_rrip_bits[i] < p_rrip_bits[uiIndex])
-            p_rrip_bits[i]++;
+        m_owner_count[m_block_owner[index]]--;
     }
 
-    p_rrip_bits[uiIndex] = 0;
-   
-    //if 0
-    for (UInt32 i = 0; i < associativity;  i++)
+    m_owner_count[core_id]++;
+    m_block_owner[index] = core_id;
+    m_block_sharers[index] = 1 << (core_id % 8);
+    m_recency.setOwner(index, core_id);
+}
+
+/* Hit by core_id: the first hit by a second core makes the block shared */
+void
+CacheSetDBASP::addSharer(UInt32 index, core_id_t core_id)
+{
+    bool was_shared = isShared(index);
+
+    m_block_sharers[index] |= 1 << (core_id % 8);
+
+    if (!was_shared && isShared(index))
+    {
+        g_numSharedBlocks++;
+        m_owner_count[m_block_owner[index]]--;
+        m_recency.setOwner(index, RecencyStack::OWNER_SHARED);
+    }
+}
+
+/* Partition enforcement: evict the LRU block of the core that is furthest
+ * over its quota. If no core is over its quota, the requesting core replaces
+ * its own LRU block, or the LRU block of the set if it holds none. With two
+ * cores and quotas adding up to the associativity this is the original
+ * ways_C0/ways_C1 rule. Shared blocks (srrip/sharer_aware) belong to no
+ * core and only go as the LRU block of the set.
+ */
+UInt32
+CacheSetDBASP::getPartitionVictim(core_id_t core_id)
+{
+    UInt32 victim_core = g_num_cores;
+    SInt32 max_excess  = 0;
+
+    for (UInt32 i = 0; i < g_num_cores; i++)
+    {
+        SInt32 excess = (SInt32)m_owner_count[i] - (SInt32)g_way_quota[i];
+
+        if (excess > max_excess)
+        {
+            max_excess  = excess;
+            victim_core = i;
+        }
+    }
+
+    if (victim_core < g_num_cores)
     {
-        printf("%u:%u  ", i, p_rrip_bits[i]);
-    } 
+        #if 0
+        printf("\nCore%u block evicted:%u", victim_core, m_recency.getLRUWay(victim_core));
+        #endif
+        return m_recency.getLRUWay(victim_core);
+    }
 
-    printf("\nRecencyCtr\n");
-    for(UInt32 i = 0; i < associativity; i++)
+    if (m_owner_count[core_id] > 0)
     {
-       printf("%u:%lu  ", i, g_recencyCounterC0[i]); 
+        return m_recency.getLRUWay(core_id);
     }
-    //#endif
+
+    return m_recency.getWay(m_associativity - 1);
 }
 
 UInt32
@@ -314,59 +867,169 @@ CacheSetDBASP::InsertBlockAtIndex(UInt32 index, core_id_t core_id)
 
     LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate");
 
+    if (m_params->sharer_aware && isShared(index))
+    {
+        g_numSharedEvictions++;
+    }
+
     /* Find if the victim block is dead blocks */
     if (0 == m_block_access[index])
     {
         /* Block is dead, findout who was its owner */
-        (0 == m_block_owner[index]) ? g_numTotalDeadBlocksC0++ : g_numTotalDeadBlocksC1++;
-        (0 == m_block_owner[index]) ? g_ValidDeadBlocksC0++  : g_ValidDeadBlocksC1++;
+        if (m_block_owner[index] < g_num_cores)
+        {
+            g_numTotalDeadBlocks[m_block_owner[index]]++;
+            g_ValidDeadBlocks[m_block_owner[index]]++;
+        }
+
+        if (g_heat_enabled)
+        {
+            g_set_heat[m_setID].dead++;
+        }
     }
     
-    /* Prepare way for a new line: set prediction to 'long' */
-    if (core_id == 0)
+    /* Reset its access counters */
+    m_block_access[index] = 0;
+    setBlockOwner(index, core_id);
+
+    g_numTotalBlocksIns[core_id]++;
+    g_InsValidBlocks[core_id]++;
+    countUCPFill(core_id, g_ucp_weight[m_setID]);
+
     {
-        //m_rrip_bits[index] = g_core0_insert;
-        g_numTotalBlocksInsC0++;
-        g_InsValidBlocksC0++;
+        UInt32 position = m_recency.getPosition(index);
+
+        #if 0
+        printf("\nEviction at Index:%u position:%u\n", index, position);
+        #endif
+        m_recency.moveTo(index, getInsertionPosition(position));
     }
-    else if (core_id == 1)
+     
+    return index;
+}
+
+/* Fill of an invalid way: no victim, the block goes to (LRU - 1) */
+UInt32
+CacheSetDBASP::InsertBlockAtInvalidIndex(UInt32 index, core_id_t core_id)
+{
+    /* Reset its access counters */
+    m_block_access[index] = 0;
+    setBlockOwner(index, core_id);
+
+    g_numTotalBlocksIns[core_id]++;
+    countUCPFill(core_id, g_ucp_weight[m_setID]);
+    
+    g_numBlocksInvalid++;
+ 
+    #if 0
+    printf("\nEviction at Index:%u\n", index);
+    #endif
+    m_recency.moveTo(index, getInsertionPosition(m_associativity - 1));
+
+    return index;
+}
+
+/* Way-mask mode: the victim is the first invalid way in the core's mask,
+ * otherwise the least recently used way in the mask */
+UInt32
+CacheSetDBASP::getWayMaskReplacementIndex(core_id_t core_id, UInt32 &path)
+{
+    UInt64 mask    = g_way_mask[core_id];
+    UInt64 invalid = 0;
+
+    for (UInt32 i = 0; i < m_associativity; i++)
     {
-        //m_rrip_bits[index] = g_core1_insert;
-        g_numTotalBlocksInsC1++;
-        g_InsValidBlocksC1++;
+        invalid |= UInt64(!m_cache_block_info_array[i]->isValid()) << i;
     }
-    else
+
+    if (invalid & mask)
     {
-        printf("\n\n\n[Newton]ERROR!!!!\n\n\n");
+        path = MISS_PATH_WAYMASK_INVALID;
+        m_recency.checkWayMaskVictim(mask, invalid, __builtin_ctzll(invalid & mask));
+        return InsertBlockAtInvalidIndex(__builtin_ctzll(invalid & mask), core_id);
     }
-    
-    /* Reset its access counters */
-    m_block_access[index] = 0;
-    m_block_owner[index] = core_id;
 
-    printf("\nEviction at Index:%u rrpv%u\n", index, m_rrip_bits[index]);
-    insertBlockToNearToLRUposition(index, m_rrip_bits, m_associativity, m_rrip_bits[index]);
-     
-    return index;
+    path = MISS_PATH_WAYMASK;
+    m_replacement_pointer = m_recency.getLRUWayInMask(mask);
+    m_recency.checkWayMaskVictim(mask, invalid, m_replacement_pointer);
+
+    return InsertBlockAtIndex(m_replacement_pointer, core_id);
 }
 
 UInt32
 CacheSetDBASP::getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id)
 {
-    static UInt64 million_cycle_count = 1;
-    
+    if (PolicyWarming::isWarming())
+    {
+        return WarmReplacementIndex(core_id);
+    }
+
+    UInt64 tsc = PolicyTimer::start();
+    UInt32 path;
+
+    #if 0
     printf("\nEviction: SetID=%u\n", m_setID);
-    
-    if (g_cycles_count / (1000000 * million_cycle_count))
+    #endif
+
+    UInt32 index = FindReplacementIndex(cntlr, core_id, path);
+
+    if (g_heat_enabled)
     {
-        printf("\n[Newton] UCP called %lu times @ %lu", million_cycle_count, g_cycles_count);
-        /* Calling partitioning function after */
-        UCPpartition();
+        SetHeat &heat = g_set_heat[m_setID];
 
-        million_cycle_count = g_cycles_count / 1000000;
-        printf("\nMillionCycleCnt:%lu", million_cycle_count);                
+        heat.misses++;
 
-        million_cycle_count++;
+        if (core_id < 2)
+        {
+            heat.fills[core_id]++;
+        }
+    }
+
+    g_missTimer.stop(tsc, path);
+
+    return index;
+}
+
+/* Miss while warming: same victim and recency update as the detailed
+ * path, without statistics, monitors or output */
+UInt32
+CacheSetDBASP::WarmReplacementIndex(core_id_t core_id)
+{
+    UInt64 mask    = g_waymask_mode ? g_way_mask[core_id] : g_all_ways_mask;
+    UInt64 invalid = 0;
+    UInt32 index, position;
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        invalid |= UInt64(!m_cache_block_info_array[i]->isValid()) << i;
+    }
+
+    if (invalid & mask)
+    {
+        index    = __builtin_ctzll(invalid & mask);
+        position = m_associativity - 1;
+    }
+    else
+    {
+        index    = g_waymask_mode ? m_recency.getLRUWayInMask(mask) : getPartitionVictim(core_id);
+        position = m_recency.getPosition(index);
+
+        m_replacement_pointer = (index + 1) % m_associativity;
+    }
+
+    m_block_access[index] = 0;
+    setBlockOwner(index, core_id);
+    m_recency.moveTo(index, getInsertionPosition(position));
+
+    return index;
+}
+
+UInt32
+CacheSetDBASP::FindReplacementIndex(CacheCntlr *cntlr, core_id_t core_id, UInt32 &path)
+{
+    if (g_waymask_mode)
+    {
+        return getWayMaskReplacementIndex(core_id, path);
     }
 
    for (UInt32 i = 0; i < m_associativity; i++)
@@ -375,97 +1038,30 @@ CacheSetDBASP::getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id)
         {
             /* If there is an invalid line(s) in the set, regardless of the LRU bits
              * of other lines, we choose the first invalid line to replace
-             * Prepare way for a new line: set prediction to 'long'
              */
-            if (core_id == 0)
-            {
-                //m_rrip_bits[i] = g_core0_insert;
-                g_numTotalBlocksInsC0++;
-            }
-            else if (core_id == 1)
-            {
-                //m_rrip_bits[i] = g_core1_insert;
-                g_numTotalBlocksInsC1++;
-            }
-            else
-            {
-                printf("\n\n\n[Newton]ERROR!!!!\n\n\n");
-            }
-
-            /* Reset its access counters */
-            m_block_access[i] = 0;
-            m_block_owner[i]  = core_id;
-            
-            g_numBlocksInvalid++;
-         
-            printf("\nEviction at Index:%u\n", i);
-            insertBlockToNearToLRUposition(i, m_rrip_bits, m_associativity, m_rrip_max);
-	        return i;
+            path = MISS_PATH_INVALID;
+            return InsertBlockAtInvalidIndex(i, core_id);
         }
     }
 
         
     {
-
-        UInt32 rrip_blocksC0[16];
-        UInt32 rrip_blocksC1[16];
-        UInt32 blockC0_index[16];
-        UInt32 blockC1_index[16];
-        
-        UInt32 num_rrip_blocksC0 = 0;
-        UInt32 num_rrip_blocksC1 = 0;
-        UInt32 eviction_C0 = 0;
-        UInt32 eviction_C1 = 0;
-
-        for (UInt32 i = 0; i < m_associativity; i++)
+        #if 0
+        if (g_num_cores > 1)
         {
-            if (0 == m_block_owner[i])
-            {
-                rrip_blocksC0[num_rrip_blocksC0] = m_rrip_bits[i];
-                blockC0_index[num_rrip_blocksC0] = i;    
-                num_rrip_blocksC0++;
-            }
-            else if (1 == m_block_owner[i])
-            {
-                rrip_blocksC1[num_rrip_blocksC1] = m_rrip_bits[i];
-                blockC1_index[num_rrip_blocksC1] = i;    
-                num_rrip_blocksC1++;
-            }
-        }
-            
-        eviction_C0 = getLRUCandidate(rrip_blocksC0, num_rrip_blocksC0);
-        eviction_C1 = getLRUCandidate(rrip_blocksC1, num_rrip_blocksC1);
-
-        /* To find true eviction index in the entire LRU stack: 16 ways */
-        eviction_C0 = blockC0_index[eviction_C0];
-        eviction_C1 = blockC1_index[eviction_C1];
-  
-        if ((0 !=  m_block_owner[eviction_C0]) || (1 !=  m_block_owner[eviction_C1]))
-        {
-            LOG_PRINT_ERROR("WrongOwner");
+            printf("\nWays C0:%u C1:%u block C0:%u C1:%u", g_way_quota[0], g_way_quota[1],
+                   m_owner_count[0], m_owner_count[1]);
         }
-       
-        printf("\nWays C0:%u C1:%u block C0:%u C1:%u", ways_C0, ways_C1, num_rrip_blocksC0, num_rrip_blocksC1);
+        #endif
 
-        if (ways_C0 > num_rrip_blocksC0)
-        {
-           /* The number of ways allocated to core0 is more than what
-            * is currently allocated, so we need to evict LRU block from C1 */
-            m_replacement_pointer = eviction_C1;
-            printf("\nCore1 block evicted:%u", eviction_C1);
-        }
-        else if (ways_C0 < num_rrip_blocksC0)
+        path = MISS_PATH_PARTITION;
+        m_replacement_pointer = getPartitionVictim(core_id);
+        m_recency.checkPartitionVictim(core_id, g_way_quota, g_num_cores, m_replacement_pointer);
+
+        if (m_replacement_pointer >= m_associativity)
         {
-            m_replacement_pointer = eviction_C0;
-            printf("\nCore0 block evicted:%u", eviction_C0);
+            LOG_PRINT_ERROR("WrongOwner");
         }
-        else if (ways_C0 == num_rrip_blocksC0)
-        {
-            /* If ways are equal to alloted quota, evict C0 block if new
-             * block to be inserted is from C0 and C1 if new block is of C1
-             */
-            m_replacement_pointer = (0 == core_id) ? eviction_C0 : eviction_C1;
-        } 
             
         return InsertBlockAtIndex(m_replacement_pointer, core_id);
 
@@ -478,7 +1074,19 @@ CacheSetDBASP::getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id)
 void
 CacheSetDBASP::updateReplacementIndex(UInt32 accessed_index)
 {
-    UInt8 recencyPosition = 20; //20 is a invalid recency postion in 16 way cache.
+    if (PolicyWarming::isWarming())
+    {
+        if (MAX_BLOCK_COUNT != m_block_access[accessed_index])
+        {
+            m_block_access[accessed_index]++;
+        }
+
+        m_recency.moveToMRU(accessed_index);
+        return;
+    }
+
+    UInt64 tsc = PolicyTimer::start();
+    UInt8 recencyPosition = MAX_ASSOCIATIVITY; // Invalid recency position
     
     //printf("\nUpdation: SetID=%u\n", m_setID);
 
@@ -496,36 +1104,61 @@ CacheSetDBASP::updateReplacementIndex(UInt32 accessed_index)
     }
     
     /* On hit, find which recency position was re-referenced */
-    recencyPosition = m_rrip_bits[accessed_index];
+    recencyPosition = m_recency.getPosition(accessed_index);
     //printf("\nUpdation at Index:%u RecencyIndex:%u\n", accessed_index, recencyPosition);
     
-    /* Increment the recency counter corresponding to the recency location */
-    if (0 == m_block_owner[accessed_index])
+    /* The core that hits, with sharer-aware accounting; the core that filled
+     * the block otherwise */
+    UInt32 hitter = m_block_owner[accessed_index];
+
+    if (m_params->sharer_aware)
     {
-        g_recencyCounterC0[recencyPosition]++;
-        g_numTotalBlocksHitC0++;
+        core_id_t core_id = Sim()->getCoreManager()->getCurrentCoreID();
+
+        if ((core_id >= 0) && ((UInt32)core_id < g_num_cores))
+        {
+            if ((UInt32)core_id != hitter)
+            {
+                g_numCrossCoreHits++;
+            }
+
+            addSharer(accessed_index, core_id);
+            hitter = core_id;
+        }
     }
-    else if (1 == m_block_owner[accessed_index])
+
+    /* Increment the recency counter corresponding to the recency location;
+     * UCP monitors only cores 0 and 1, the cores it partitions between */
+    if (hitter < g_num_cores)
     {
-        g_recencyCounterC1[recencyPosition]++;
-        g_numTotalBlocksHitC1++;
+        g_numTotalBlocksHit[hitter]++;
     }
-    else
+
+    if (0 == hitter)
     {
-        LOG_PRINT_ERROR("Error updating Recency Counters");
+        g_recencyCounterC0[recencyPosition]++;
+        g_ucpRecencyC0[recencyPosition] += g_ucp_weight[m_setID];
+        g_ucpAccessC0 += g_ucp_weight[m_setID];
+    }
+    else if (1 == hitter)
+    {
+        g_recencyCounterC1[recencyPosition]++;
+        g_ucpRecencyC1[recencyPosition] += g_ucp_weight[m_setID];
+        g_ucpAccessC1 += g_ucp_weight[m_setID];
     }
    
     #if 0
     printf("[Newton]: Recency Position:%u Recency Counts C0:%lu, C1:%lu\n",
-           recencyPosition, g_recencyCounterC0[recencyPosition],
-           g_recencyCounterC1[recencyPosition]);
+           recencyPosition, g_recencyCounterC0[recencyPosition].get(),
+           g_recencyCounterC1[recencyPosition].get());
     #endif       
 
     /* As per SRRIP paper, SRRIP-HP performs better than SRRIP-FP, hence
      * setting the RRPV values directly to 0 is more beneficial than
      * decreasing it slowly.
      */ 
-    insertBlockToMRUposition(accessed_index, m_rrip_bits, m_associativity);
-    m_rrip_bits[accessed_index] = 0;
+    m_recency.moveToMRU(accessed_index);
+
+    g_hitTimer.stop(tsc, 0);
 }
 
@@ -3,6 +3,8 @@
 
 #include "cache_set.h"
 #include "cache_set_lru.h"
+#include "cache_set_recency_stack.h"
+#include "cache_set_srrip_params.h"
 
 
 class CacheSetDBASP : public CacheSet
@@ -17,18 +19,31 @@ class CacheSetDBASP : public CacheSet
       UInt32 getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id);
       void updateReplacementIndex(UInt32 accessed_index);
 
+      /* Reprogram the allocation way mask of a core (way-mask mode) */
+      static void setWayMask(core_id_t core_id, UInt64 mask);
+
 
    private:
-      const UInt32 m_saturation_counter_max_value;
-      const UInt32 m_db_percent_threshold;
-      const UInt8  m_rrip_numbits;
-      const UInt8  m_rrip_max;
-      const UInt8  m_rrip_insert;
-            UInt8 *m_rrip_bits;
+      UInt32 InsertBlockAtInvalidIndex(UInt32 index, core_id_t core_id);
+      UInt32 FindReplacementIndex(CacheCntlr *cntlr, core_id_t core_id, UInt32 &path);
+      UInt32 WarmReplacementIndex(core_id_t core_id);
+      UInt32 getWayMaskReplacementIndex(core_id_t core_id, UInt32 &path);
+      void   setBlockOwner(UInt32 index, core_id_t core_id);
+      UInt32 getPartitionVictim(core_id_t core_id);
+      void   addSharer(UInt32 index, core_id_t core_id);
+      bool   isShared(UInt32 index) const
+      {
+         return 0 != (m_block_sharers[index] & (m_block_sharers[index] - 1));
+      }
+
+      const SRRIPParams *m_params;
             UInt8 *m_block_owner;
+            UInt8 *m_owner_count;   /* Ways held by each core in this set */
             UInt8 *m_block_access; /* Number of times block got accessed */
+            UInt8 *m_block_sharers;   /* Cores (modulo 8, at most 8 with sharer_aware) that filled or hit the block */
             UInt8  m_replacement_pointer;
             UInt32 m_setID;
+      RecencyStack m_recency;   /* True-LRU stack, position 0 is MRU */
       CacheSetInfoLRU* m_set_info;
 };
 
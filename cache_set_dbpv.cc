@@ -4,6 +4,8 @@
 #include "log.h"
 #include "cache.h"
 #include "stats.h"
+#include "cache_set_stat_counter.h"
+#include "cache_set_warming.h"
 
 
 /* S-RRIP: Static Re-reference Interval Prediction policy
@@ -13,81 +15,86 @@
 #define MAX_BLOCK_COUNT 3 //(2^2 - 1) 2 bit counter
 
 static UInt8  g_iteration_count         = 0;
-static UInt64 g_numTotalDeadBlocksC0    = 0;
-static UInt64 g_numTotalBlocksInsC0     = 0;
-static UInt64 g_numTotalDeadBlocksC1    = 0;
-static UInt64 g_numTotalBlocksInsC1     = 0;
-static UInt64 g_numBlocksInvalid        = 0;
-static UInt64 g_numBlocksReusedOnceC0     = 0;
-static UInt64 g_numBlocksReusedOnceC1     = 0;
-static UInt64 g_numBlocksReusedTwiceC0    = 0;
-static UInt64 g_numBlocksReusedTwiceC1    = 0;    
-static UInt64 g_numBlocksReusedThriceOrMoreC1 = 0;
-static UInt64 g_numBlocksReusedThriceOrMoreC0 = 0;
+static StatCounter g_numTotalDeadBlocksC0;
+static StatCounter g_numTotalBlocksInsC0;
+static StatCounter g_numTotalDeadBlocksC1;
+static StatCounter g_numTotalBlocksInsC1;
+static StatCounter g_numBlocksInvalid;
+static StatCounter g_numBlocksReusedOnceC0;
+static StatCounter g_numBlocksReusedOnceC1;
+static StatCounter g_numBlocksReusedTwiceC0;
+static StatCounter g_numBlocksReusedTwiceC1;
+static StatCounter g_numBlocksReusedThriceOrMoreC1;
+static StatCounter g_numBlocksReusedThriceOrMoreC0;
+static StatCounter g_numInclusionVictims;
+static StatCounter g_numInclusionSkipped;
 
 CacheSetDBPV::CacheSetDBPV(
       String cfgname, core_id_t core_id,
       CacheBase::cache_t cache_type,
       UInt32 associativity, UInt32 blocksize, CacheSetInfoLRU* set_info, UInt8 num_attempts)
    : CacheSet(cache_type, associativity, blocksize)
-   , m_rrip_numbits(Sim()->getCfg()->getIntArray(cfgname + "/srrip/bits", core_id))
-   , m_rrip_max((1 << m_rrip_numbits) - 1)
-   , m_rrip_insert(m_rrip_max - 1)
-   , m_num_attempts(num_attempts)
+   , m_params(SRRIPParams::get(cfgname, core_id, associativity, num_attempts, SRRIPParams::NEEDS_CASE))
+   , m_meta(NULL)   /* Allocated on first touch of the set */
    , m_replacement_pointer(0)
-   , m_case(Sim()->getCfg()->getIntArray(cfgname + "/srrip/case", core_id))
+   , m_hits_lo(0)
+   , m_hits_hi(0)
    , m_set_info(set_info)
 {
-   m_rrip_bits = new UInt8[m_associativity];
-   for (UInt32 i = 0; i < m_associativity; i++)
-      m_rrip_bits[i] = m_rrip_insert;
-
-    /* To record how many times a block got hit */
-    m_block_access = new UInt8[m_associativity];
-    for (UInt8 i = 0; i < m_associativity; i++)
-    {
-        m_block_access[i] = 0;
-    }
-    
-    /* To record which core brought the block into cache */
-    m_block_owner = new UInt8[m_associativity];
-    for (UInt8 i = 0; i < m_associativity; i++)
-    {
-        m_block_owner[i] = 0;
-    }
-
     if (0 == g_iteration_count)
     {
         g_iteration_count++;
 
-        printf("\n[Newton] DBPV with associativity:%d Case:%d!!!\n", m_associativity, m_case);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksDeadC0", &g_numTotalDeadBlocksC0);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksReusedOnceC0", &g_numBlocksReusedOnceC0);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksReusedTwiceC0", &g_numBlocksReusedTwiceC0);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksReusedThriceOrMoreC0", &g_numBlocksReusedThriceOrMoreC0);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksInsC0",  &g_numTotalBlocksInsC0);
+        printf("\n[Newton] DBPV with associativity:%d Case:%d Kernel:%s!!!\n", m_associativity, m_params->dbpv_case, m_params->kernel->name);
+        g_numTotalDeadBlocksC0.registerMetric("interval_timer", core_id, "totalBlocksDeadC0");
+        g_numBlocksReusedOnceC0.registerMetric("interval_timer", core_id, "totalBlocksReusedOnceC0");
+        g_numBlocksReusedTwiceC0.registerMetric("interval_timer", core_id, "totalBlocksReusedTwiceC0");
+        g_numBlocksReusedThriceOrMoreC0.registerMetric("interval_timer", core_id, "totalBlocksReusedThriceOrMoreC0");
+        g_numTotalBlocksInsC0.registerMetric("interval_timer", core_id, "totalBlocksInsC0");
 
-        registerStatsMetric("interval_timer", core_id, "totalBlocksDeadC1", &g_numTotalDeadBlocksC1);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksReusedOnceC1", &g_numBlocksReusedOnceC1);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksReusedTwiceC1", &g_numBlocksReusedTwiceC1);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksReusedThriceOrMoreC1", &g_numBlocksReusedThriceOrMoreC1);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksInsC1",  &g_numTotalBlocksInsC1);
+        g_numTotalDeadBlocksC1.registerMetric("interval_timer", core_id, "totalBlocksDeadC1");
+        g_numBlocksReusedOnceC1.registerMetric("interval_timer", core_id, "totalBlocksReusedOnceC1");
+        g_numBlocksReusedTwiceC1.registerMetric("interval_timer", core_id, "totalBlocksReusedTwiceC1");
+        g_numBlocksReusedThriceOrMoreC1.registerMetric("interval_timer", core_id, "totalBlocksReusedThriceOrMoreC1");
+        g_numTotalBlocksInsC1.registerMetric("interval_timer", core_id, "totalBlocksInsC1");
 
-        registerStatsMetric("interval_timer", core_id, "InvalidBlocks",     &g_numBlocksInvalid);
+        g_numBlocksInvalid.registerMetric("interval_timer", core_id, "InvalidBlocks");
+        g_numInclusionVictims.registerMetric("interval_timer", core_id, "inclusionVictims");
+        g_numInclusionSkipped.registerMetric("interval_timer", core_id, "inclusionSkipped");
+
+        if (m_params->fast_warming)
+        {
+            printf("[Newton] DBPV fast warming enabled\n");
+            PolicyWarming::enable(NULL);
+        }
     }
 }
 
 CacheSetDBPV::~CacheSetDBPV()
 {
-   delete [] m_rrip_bits;
+   /* m_meta belongs to the arena */
+}
+
+/* First access to the set: take its arrays from the arena, a fresh chunk
+ * is zeroed, only the RRPVs need their initial value */
+void
+CacheSetDBPV::AllocateMeta()
+{
+   m_meta = SetMetaArena::get(META_ARRAYS * m_associativity)->allocate();
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+      rripBits()[i] = m_params->rrip_insert;
 }
 
 UInt32
 CacheSetDBPV::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
 {
-    UInt8 core0_insert = m_rrip_insert, core1_insert = m_rrip_insert;
+    touchMeta();
+    ApplyDeferredHits();
+
+    UInt8 core0_insert = m_params->rrip_insert, core1_insert = m_params->rrip_insert;
     
-    switch (m_case)
+    switch (m_params->dbpv_case)
     {
         case 1: core0_insert = 0; core1_insert = 0; break; //MRU
         case 2: core0_insert = 1; core1_insert = 1; break;
@@ -102,6 +109,11 @@ CacheSetDBPV::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
         case 11: core0_insert = 3; core1_insert = 2; break;
         case 12: core0_insert = 2; core1_insert = 3; break;
     }
+
+    if (PolicyWarming::isWarming())
+    {
+        return WarmReplacementIndex(core_id, (0 == core_id) ? core0_insert : core1_insert);
+    }
     
     for (UInt32 i = 0; i < m_associativity; i++)
     {
@@ -113,12 +125,12 @@ CacheSetDBPV::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
              */
             if (core_id == 0)
             {
-                m_rrip_bits[i] = core0_insert;
+                rripBits()[i] = core0_insert;
                 g_numTotalBlocksInsC0++;
             }
             else if (core_id == 1)
             {
-                m_rrip_bits[i] = core1_insert;
+                rripBits()[i] = core1_insert;
                 g_numTotalBlocksInsC1++;
             }
             else
@@ -127,8 +139,8 @@ CacheSetDBPV::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
             }
 
             /* Reset its access counters */
-            m_block_access[i] = 0;
-            m_block_owner[i] = core_id;
+            blockAccess()[i] = 0;
+            blockOwner()[i] = core_id;
             
             g_numBlocksInvalid++;
          
@@ -136,159 +148,283 @@ CacheSetDBPV::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
         }
     }
 
-   for(UInt32 j = 0; j <= m_rrip_max; ++j)
+   UInt64 candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+
+   // Increment all RRIP counters until one hits RRIP_MAX
+   if (0 == candidates)
+   {
+      m_params->kernel->age(rripBits(), m_associativity, m_params->rrip_max);
+      candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+   }
+
+   UInt32 num_queries = 0;
+   UInt32 index = m_associativity;
+   UInt32 inclusion_victim = m_associativity;
+
+   /* We choose the first non-touched line as the victim (note that we
+    * start searching from the replacement pointer position)
+    */
+   for (UInt64 remaining = candidates; remaining; )
    {
-      for (UInt32 i = 0; i < m_associativity; i++)
+      UInt32 way = nextWayInMask(remaining, m_replacement_pointer);
+
+      if (!IsInclusionVictim(cntlr, way, num_queries))
       {
-         if (m_rrip_bits[m_replacement_pointer] >= m_rrip_max)
-         {
-            /* We choose the first non-touched line as the victim (note that we
-             * start searching from the replacement pointer position)
-             */
-            UInt8 index = m_replacement_pointer;
+         index = way;
+         break;
+      }
+
+      /* Line is still held by a private cache, keep looking for another
+       * line at rrip_max and fall back to this one */
+      if (m_associativity == inclusion_victim)
+      {
+         inclusion_victim = way;
+      }
 
-            m_replacement_pointer = (m_replacement_pointer + 1) % m_associativity;
+      remaining &= ~(UInt64(1) << way);
+   }
 
-            LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate");
+   /* Every line at rrip_max is present in a private cache: evict the
+    * first one rather than ageing the rest of the set */
+   if (m_associativity == index)
+   {
+      g_numInclusionVictims++;
+      index = inclusion_victim;
+   }
 
-            /* If the block was never accessed more than once, it is dead */
-            switch (m_block_access[index])
-            {
-                case 0: 
-                {
-                    if (0 == m_block_owner[index])
-                    {
-                        g_numTotalDeadBlocksC0++;
-                    }
-                    else if (1 == m_block_owner[index])
-                    {
-                        g_numTotalDeadBlocksC1++;
-                    }
-                    else
-                    {
-                        printf("\n\n\n[Newton] DeadBLock0: CoreInfo ERROR!!!!\n\n\n");
-                    }
-                    
-                    break;
-                }
-
-                case 1: 
-                {
-                    if (0 == m_block_owner[index])
-                    {
-                        g_numBlocksReusedOnceC0++;
-                    }
-                    else if (1 == m_block_owner[index])
-                    {
-                        g_numBlocksReusedOnceC1++;
-                    }
-                    else
-                    {
-                        printf("\n\n\n[Newton] DeadBLock1: CoreInfo ERROR!!!!\n\n\n");
-                    }
-
-                    break;
-                }
-
-                case 2:
-                {
-                    if (0 == m_block_owner[index])
-                    {
-                        g_numBlocksReusedTwiceC0++;
-                    }
-                    else if (1 == m_block_owner[index])
-                    {
-                        g_numBlocksReusedTwiceC1++;
-                    }
-                    else
-                    {
-                        printf("\n\n\n[Newton] DeadBLock2: CoreInfo ERROR!!!!\n\n\n");
-                    }
-
-                    break;
-                }
-
-                case 3:
-                {
-                    if (0 == m_block_owner[index])
-                    {
-                        g_numBlocksReusedThriceOrMoreC0++;
-                    }
-                    else if (1 == m_block_owner[index])
-                    {
-                        g_numBlocksReusedThriceOrMoreC1++;
-                    }
-                    else
-                    {
-                        printf("\n\n\n[Newton] DeadBLock3: CoreInfo ERROR!!!!\n\n\n");
-                    }
-
-                    break;
-                }
-                
-                default:
-                printf("\n\n\n[Newton] Default: CoreInfo ERROR %d!!!!\n\n\n", m_block_access[index]);
-            }
-                
+   m_replacement_pointer = (index + 1) % m_associativity;
 
-            /* Prepare way for a new line: set prediction to 'long' */
-            if (core_id == 0)
-            {
-                m_rrip_bits[index] = core0_insert;
-                g_numTotalBlocksInsC0++;
-            }
-            else if (core_id == 1)
-            {
-                m_rrip_bits[index] = core1_insert;
-                g_numTotalBlocksInsC1++;
-            }
-            else
-            {
-                printf("\n\n\n[Newton]ERROR!!!!\n\n\n");
-            }
-            
-            /* Reset its access counters */
-            m_block_access[index] = 0;
-            m_block_owner[index] = core_id;
+   LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate");
+
+   /* If the block was never accessed more than once, it is dead */
+   switch (blockAccess()[index])
+   {
+       case 0: 
+       {
+           if (0 == blockOwner()[index])
+           {
+               g_numTotalDeadBlocksC0++;
+           }
+           else if (1 == blockOwner()[index])
+           {
+               g_numTotalDeadBlocksC1++;
+           }
+           else
+           {
+               printf("\n\n\n[Newton] DeadBLock0: CoreInfo ERROR!!!!\n\n\n");
+           }
 
-            return index;
-         }
+           break;
+       }
 
-         m_replacement_pointer = (m_replacement_pointer + 1) % m_associativity;
-     }
+       case 1: 
+       {
+           if (0 == blockOwner()[index])
+           {
+               g_numBlocksReusedOnceC0++;
+           }
+           else if (1 == blockOwner()[index])
+           {
+               g_numBlocksReusedOnceC1++;
+           }
+           else
+           {
+               printf("\n\n\n[Newton] DeadBLock1: CoreInfo ERROR!!!!\n\n\n");
+           }
 
-      // Increment all RRIP counters until one hits RRIP_MAX
-      for (UInt32 i = 0; i < m_associativity; i++)
-      {
-         if (m_rrip_bits[i] < m_rrip_max)
-         {
-            m_rrip_bits[i]++;
-         }
-      }
+           break;
+       }
+
+       case 2:
+       {
+           if (0 == blockOwner()[index])
+           {
+               g_numBlocksReusedTwiceC0++;
+           }
+           else if (1 == blockOwner()[index])
+           {
+               g_numBlocksReusedTwiceC1++;
+           }
+           else
+           {
+               printf("\n\n\n[Newton] DeadBLock2: CoreInfo ERROR!!!!\n\n\n");
+           }
+
+           break;
+       }
+
+       case 3:
+       {
+           if (0 == blockOwner()[index])
+           {
+               g_numBlocksReusedThriceOrMoreC0++;
+           }
+           else if (1 == blockOwner()[index])
+           {
+               g_numBlocksReusedThriceOrMoreC1++;
+           }
+           else
+           {
+               printf("\n\n\n[Newton] DeadBLock3: CoreInfo ERROR!!!!\n\n\n");
+           }
+
+           break;
+       }
+
+       default:
+       printf("\n\n\n[Newton] Default: CoreInfo ERROR %d!!!!\n\n\n", blockAccess()[index]);
+   }
+
+
+   /* Prepare way for a new line: set prediction to 'long' */
+   if (core_id == 0)
+   {
+       rripBits()[index] = core0_insert;
+       g_numTotalBlocksInsC0++;
    }
+   else if (core_id == 1)
+   {
+       rripBits()[index] = core1_insert;
+       g_numTotalBlocksInsC1++;
+   }
+   else
+   {
+       printf("\n\n\n[Newton]ERROR!!!!\n\n\n");
+   }
+
+   /* Reset its access counters */
+   blockAccess()[index] = 0;
+   blockOwner()[index] = core_id;
+
+   return index;
+}
+
+/* Miss while warming: the victim and fill of the detailed path, without
+ * the dead block and reuse statistics */
+UInt32
+CacheSetDBPV::WarmReplacementIndex(core_id_t core_id, UInt8 insert)
+{
+    UInt32 index = m_associativity;
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        if (!m_cache_block_info_array[i]->isValid())
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (m_associativity == index)
+    {
+        UInt64 candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+
+        if (0 == candidates)
+        {
+            m_params->kernel->age(rripBits(), m_associativity, m_params->rrip_max);
+            candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+        }
+
+        index = nextWayInMask(candidates, m_replacement_pointer);
+        m_replacement_pointer = (index + 1) % m_associativity;
+
+        LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate");
+    }
+
+    if ((core_id == 0) || (core_id == 1))
+    {
+        rripBits()[index] = insert;
+    }
+
+    blockAccess()[index] = 0;
+    blockOwner()[index] = core_id;
+
+    return index;
+}
+
+/* Query based selection, as in DBPV_DYN: up to srrip/qbs_attempts - 1
+ * candidates per miss are checked through the controller and skipped if
+ * a private cache still holds them. srrip/inclusion_stats counts the
+ * inclusion victims of candidates accepted without a query. */
+bool
+CacheSetDBPV::IsInclusionVictim(CacheCntlr *cntlr, UInt32 index, UInt32 &num_queries)
+{
+    if (NULL == cntlr)
+    {
+        return false;
+    }
+
+    if (num_queries + 1 < m_params->num_attempts)
+    {
+        num_queries++;
+
+        if (cntlr->isInLowerLevelCache(m_cache_block_info_array[index]))
+        {
+            g_numInclusionSkipped++;
+            return true;
+        }
 
-   LOG_PRINT_ERROR("Error finding replacement index");
+        return false;
+    }
+
+    if (m_params->inclusion_stats && cntlr->isInLowerLevelCache(m_cache_block_info_array[index]))
+    {
+        g_numInclusionVictims++;
+    }
+
+    return false;
 }
 
 void
-CacheSetDBPV::updateReplacementIndex(UInt32 accessed_index)
+CacheSetDBPV::PromoteBlock(UInt32 index, UInt32 hits)
 {
     /* If block access count have reached saturation limit MAX_BLOCK_COUNT,
      * keep the counter saturated.
      */
-    if (MAX_BLOCK_COUNT != m_block_access[accessed_index])
-    {
-        m_block_access[accessed_index]++;
-    }
+    blockAccess()[index] = (blockAccess()[index] + hits < MAX_BLOCK_COUNT) ? blockAccess()[index] + hits : MAX_BLOCK_COUNT;
     
    /* As per SRRIP paper, SRRIP-HP performs better than SRRIP-FP, hence
     * setting the RRPV values directly to 0 is more beneficial than
     * decreasing it slowly.
     */ 
-    if (m_rrip_bits[accessed_index] > 0)
+    if (rripBits()[index] > 0)
     {
-        m_rrip_bits[accessed_index] = 0;
+        rripBits()[index] = 0;
     }
 }
 
+/* Promotions of the hits since the last miss. The RRPV goes straight to 0
+ * and the access counter saturates at 3, same as the deferred count, so the
+ * state is the one of promoting on every hit. */
+void
+CacheSetDBPV::ApplyDeferredHits()
+{
+    for (UInt64 touched = m_hits_lo | m_hits_hi; touched; touched &= touched - 1)
+    {
+        UInt32 index = __builtin_ctzll(touched);
+
+        PromoteBlock(index, ((m_hits_lo >> index) & 1) | (((m_hits_hi >> index) & 1) << 1));
+    }
+
+    m_hits_lo = 0;
+    m_hits_hi = 0;
+}
+
+void
+CacheSetDBPV::updateReplacementIndex(UInt32 accessed_index)
+{
+    if (m_params->deferred_hits)
+    {
+        UInt64 way = UInt64(1) << accessed_index;
 
+        /* Saturating increment of the two bit planes: 3 stays 3 */
+        UInt64 saturated = m_hits_lo & m_hits_hi & way;
+
+        m_hits_hi |= m_hits_lo & way;
+        m_hits_lo  = (m_hits_lo ^ way) | saturated;
+        return;
+    }
+
+    touchMeta();
+    PromoteBlock(accessed_index, 1);
+}
@@ -3,6 +3,8 @@
 
 #include "cache_set.h"
 #include "cache_set_lru.h"
+#include "cache_set_srrip_params.h"
+#include "cache_set_meta_arena.h"
 
 
 //UInt32 m_glob_core_id;
@@ -19,15 +21,35 @@ class CacheSetDBPV : public CacheSet
 
 
    private:
-      const UInt8  m_rrip_numbits;
-      const UInt8  m_rrip_max;
-      const UInt8  m_rrip_insert;
-      const UInt8  m_num_attempts;
-            UInt8 *m_rrip_bits;
-            UInt8 *m_block_owner;
-            UInt8 *m_block_access; /* Number of times block got accessed */
+      void AllocateMeta();
+      void PromoteBlock(UInt32 index, UInt32 hits);
+      UInt32 WarmReplacementIndex(core_id_t core_id, UInt8 insert);
+      void ApplyDeferredHits();
+      bool IsInclusionVictim(CacheCntlr *cntlr, UInt32 index, UInt32 &num_queries);
+
+      void touchMeta()
+      {
+         if (NULL == m_meta)
+         {
+            AllocateMeta();
+         }
+      }
+
+      /* Per-way arrays, packed in one arena chunk: RRPV, owner core and
+       * number of times the block got accessed */
+      enum { META_RRIP = 0, META_OWNER, META_ACCESS, META_ARRAYS };
+
+      UInt8* rripBits()    const { return m_meta + META_RRIP   * m_associativity; }
+      UInt8* blockOwner()  const { return m_meta + META_OWNER  * m_associativity; }
+      UInt8* blockAccess() const { return m_meta + META_ACCESS * m_associativity; }
+
+      const SRRIPParams *m_params;
+            UInt8 *m_meta;   /* NULL until the set is first touched */
             UInt8  m_replacement_pointer;
-            UInt8  m_case;
+            /* Hits since the last miss (srrip/deferred_hits), a saturating
+             * two bit count per way kept as two bit planes */
+            UInt64 m_hits_lo;
+            UInt64 m_hits_hi;
       CacheSetInfoLRU* m_set_info;
 };
 
@@ -4,6 +4,14 @@
 #include "log.h"
 #include "cache.h"
 #include "stats.h"
+#include "cache_set_stat_counter.h"
+#include "cache_set_timing.h"
+#include "core_manager.h"
+#include "cache_set_warming.h"
+#include "cache_set_daaip_ucp_rules.h"
+#include "config.h"
+
+extern UInt64 g_cycles_count;
 
 /* Each cache block have been appended with a 1-bit counter
  * which measure if the block has been reused or not. 1 bit
@@ -14,26 +22,42 @@
 */
 
 #define MAX_BLOCK_COUNT                 1      //(2^1 - 1) 1 bit counter
-#define LARGEST_16_BIT_NUMBER           65535  //(2^16 - 1) 16 bit counter
-#define TOTAL_NUM_CACHE_BLOCKS          65536  // Number of cache blocks in 4BM cache
 #define DB_PERCENT_THRESHOLD_99         9999    
 #define DB_PERCENT_THRESHOLD_90         9000    
 
 static UInt8  g_iteration_count         = 0;
-static UInt64 g_numTotalDeadBlocksC0    = 0;
-static UInt64 g_numTotalBlocksInsC0     = 0;
-static UInt64 g_numTotalDeadBlocksC1    = 0;
-static UInt64 g_numTotalBlocksInsC1     = 0;
-static UInt64 g_numBlocksInvalid        = 0;
-static UInt64 g_numTieAtEvict           = 0;
+static StatCounter g_numTotalDeadBlocksC0;
+static StatCounter g_numTotalBlocksInsC0;
+static StatCounter g_numTotalDeadBlocksC1;
+static StatCounter g_numTotalBlocksInsC1;
+static StatCounter g_numBlocksInvalid;
+static StatCounter g_numTieAtEvict;
 static UInt64 g_numPhases               = 0;
 
 static UInt32 g_phaseID                 = 0;
 
 #define NUM_PHASES 100
+#define NUM_ACCESS_BUCKETS 5   /* 0..3 accesses, the last one is 4 or more */
 
 /* To find the number of accesses to each block accessed */
-static UInt64  g_block_access_count[NUM_PHASES][10];
+static StatCounter g_block_access_count[NUM_PHASES][NUM_ACCESS_BUCKETS];
+
+/* Phase statistics are registered when the phase starts, not all
+ * NUM_PHASES up front; most runs see only a handful of phases */
+static core_id_t g_stats_core_id        = 0;
+static UInt32    g_numRegisteredPhases  = 0;
+
+static void registerPhaseStats(UInt32 phase)
+{
+    for (; (g_numRegisteredPhases <= phase) && (g_numRegisteredPhases < NUM_PHASES); g_numRegisteredPhases++)
+    {
+        for (UInt32 i = 0; i < NUM_ACCESS_BUCKETS; i++)
+        {
+            g_block_access_count[g_numRegisteredPhases][i].registerMetric("interval_timer", g_stats_core_id,
+                String("dbpv_block-access-count-")+itostr(g_numRegisteredPhases)+"-"+itostr(i));
+        }
+    }
+}
 
 
 /* For each phase, i want to record the access trace
@@ -49,11 +73,11 @@ static UInt64  g_block_access_count[NUM_PHASES][10];
  * and count their numbers and their access counts.
  */ 
 
-/* These are 16 bit counters */
-static UInt32 g_ValidDeadBlocksC0    = 0;
-static UInt32 g_InsValidBlocksC0     = 0;
-static UInt32 g_ValidDeadBlocksC1    = 0;
-static UInt32 g_InsValidBlocksC1     = 0;
+/* 64 bit, so that max_value can be set to the block count of any cache */
+static UInt64 g_ValidDeadBlocksC0    = 0;
+static UInt64 g_InsValidBlocksC0     = 0;
+static UInt64 g_ValidDeadBlocksC1    = 0;
+static UInt64 g_InsValidBlocksC1     = 0;
 
 static UInt8 g_core0_insert, g_core1_insert;
 
@@ -61,69 +85,348 @@ static UInt8  g_insertionCore0[1024];
 static UInt8  g_insertionCore1[1024];
 static UInt16 g_iteration = 0;
 
+/* Prefetch-aware insertion (srrip/prefetch_aware). The stride prefetcher fills
+ * the LLC through the same path as demand misses, so a core issuing useless
+ * prefetches looks like a streaming core and ends up with its demand lines at
+ * rrip_max too. Prefetched blocks carry their own bit; they are kept out of
+ * the demand dead-block statistic and their reuse bit at eviction gives the
+ * per-core prefetch accuracy (in units of 0.01%, like db_percent).
+ */
+#define PREFETCH_INSERT_DEMAND          0      // Insert like a demand block of the core
+#define PREFETCH_INSERT_DISTANT         1      // Insert at rrip_max
+#define PREFETCH_BYPASS                 2      // Insert at rrip_max, next victim of the set
+
+static StatCounter g_numPrefetchFills[2];
+static StatCounter g_numPrefetchUseful[2];
+static StatCounter g_numPrefetchUseless[2];
+static StatCounter g_numPrefetchBypassed[2];
+static UInt32 g_prefetchUsefulWindow[2];
+static UInt32 g_prefetchDoneWindow[2];
+static UInt8  g_prefetchInsertMode[2];
+
+/* Lines evicted while present in a private cache, and candidates skipped
+ * because of that */
+static StatCounter g_numInclusionVictims;
+static StatCounter g_numInclusionSkipped;
+
+/* Sharer tracking (srrip/sharer_aware): blocks hit by more than one core,
+ * hits by a core other than the one that filled the block, and the
+ * evictions of shared blocks. A shared block is live for its filler even
+ * if only the other cores hit it. */
+static StatCounter g_numSharedBlocks;
+static StatCounter g_numCrossCoreHits[2];
+static StatCounter g_numSharedEvictions[2];
+
+/* Bimodal insertion (srrip/bimodal). A core at rrip_max still inserts
+ * epsilon of its demand fills at rrip_insert, as BRRIP does, so a working
+ * set slightly larger than the cache keeps a foothold. epsilon (0.01%
+ * units, like db_percent) is set per core at the end of its window: it
+ * falls linearly from bimodal_epsilon_max at db_threshold to
+ * bimodal_epsilon_min at 100% dead blocks. Both cores may then be at
+ * rrip_max at the same time. One xorshift generator per cache; like the
+ * rest of the DAAIP state, there is one DAAIP cache.
+ */
+static bool   g_bimodal = false;
+static UInt32 g_bimodalEpsilon[2];
+static UInt32 g_bimodalEpsilonMin;
+static UInt32 g_bimodalEpsilonMax;
+static UInt32 g_bimodalRng;
+static StatCounter g_numBimodalNear[2];
+
+/* Uniform in 0..9999 */
+static inline UInt32 BimodalDraw()
+{
+    g_bimodalRng ^= g_bimodalRng << 13;
+    g_bimodalRng ^= g_bimodalRng >> 17;
+    g_bimodalRng ^= g_bimodalRng << 5;
+
+    return g_bimodalRng % 10000;
+}
+
+static UInt32 BimodalEpsilon(UInt32 db_percent, UInt32 db_percent_threshold)
+{
+    if ((db_percent < db_percent_threshold) || (db_percent_threshold >= 10000))
+    {
+        return g_bimodalEpsilonMax;
+    }
+
+    if (db_percent >= 10000)
+    {
+        return g_bimodalEpsilonMin;
+    }
+
+    return g_bimodalEpsilonMax - (UInt64)(g_bimodalEpsilonMax - g_bimodalEpsilonMin)
+                                 * (db_percent - db_percent_threshold) / (10000 - db_percent_threshold);
+}
+
+/* Sets whose metadata has been allocated */
+static StatCounter g_numTouchedSets;
+
+/* Residency, time to last hit, dead time and hits of every generation
+ * (srrip/lifetime_stats): the block times DAAIP's phase window and dead
+ * block threshold are chosen from */
+static LifetimeTracker g_lifetime;
+
+/* Online tuning of db_threshold and max_value (srrip/autotune), by set
+ * dueling. Out of every tune_period sets, NUM_TUNE_GROUPS are leaders:
+ * group 0 runs the live parameters, each other group one neighbour of
+ * them, db_threshold one tune_threshold_step lower/higher or the phase
+ * window (max_value) halved/doubled. Every group, the control group too,
+ * keeps its own dead-block window and insertion positions. A group sees
+ * one set in tune_period, so its window is the phase window divided by
+ * tune_period, and the window carries over from epoch to epoch. After
+ * tune_epoch misses in the leader sets, the live parameters take the
+ * values of the group with the fewest misses if it beats group 0 by more
+ * than tune_margin, and the neighbours are placed around them again.
+ * Followers use the live parameters and the whole-cache window.
+ */
+#define NUM_TUNE_GROUPS                 5
+#define TUNE_CONTROL                    0
+#define TUNE_FOLLOWER                   0xff
+#define TUNE_MIN_WINDOW                 64
+#define TUNE_MIN_GROUP_WINDOW           16     /* Fills, of the window of one group */
+
+struct DAAIPTuneGroup
+{
+    UInt32 db_threshold;
+    UInt32 window;          /* Phase window of the parameters, whole cache */
+    UInt64 ins[2];          /* Fills after an eviction in the current window */
+    UInt64 dead[2];
+    UInt8  insert[2];
+    UInt64 misses;          /* Misses in the current epoch */
+};
+
+static DAAIPTuneGroup g_tune[NUM_TUNE_GROUPS];
+static UInt64 g_tuneLeaderMisses        = 0;
+static FILE  *g_tune_log                = NULL;
+
+/* Live parameters, registered as stats so the interval stats hold their
+ * trajectory */
+static UInt64 g_liveDbThreshold         = 0;
+static UInt64 g_liveWindow              = 0;
+static UInt64 g_tuneEpochs              = 0;
+
+static void TuneCenter(UInt32 threshold_step);
+static void DAAIPWarmingHandoff();
+
+/* Phase signature memoization (srrip/phase_memo). A core's phase window
+ * takes max_value evicting fills to decide its insertion position, and a
+ * recurring phase is learnt again every time. After the first
+ * max_value / phase_memo_sample fills of a window, the window so far is
+ * summarized in a signature:
+ *
+ *   bits 0-2  dead fraction of the core's evicted blocks, in eighths
+ *   bits 3-5  log2 of hits per fill to the core's blocks
+ *   bits 6-7  prefetched share of the core's fills, in quarters
+ *
+ * A table per core maps every signature to the position the full window
+ * decided the last times it was seen. Once the same decision has been
+ * seen PHASE_MEMO_CONFIDENCE times in a row, it is applied at the
+ * sample point; the end of the window still decides as before.
+ */
+#define PHASE_SIG_BITS                  8
+#define PHASE_SIG_NONE                  (1 << PHASE_SIG_BITS)
+#define PHASE_MEMO_CONFIDENCE           2
+#define PHASE_MEMO_MAX_CONFIDENCE       3
+
+struct PhaseMemoEntry
+{
+    UInt8 insert;
+    UInt8 confidence;       /* 0: never seen */
+};
+
+static PhaseMemoEntry g_phaseMemo[2][1 << PHASE_SIG_BITS];
+static UInt32 g_phaseSig[2]             = { PHASE_SIG_NONE, PHASE_SIG_NONE };
+static UInt64 g_windowHits[2];          /* Hits to the core's blocks in its current window */
+static UInt64 g_windowPrefetchFills[2];
+
+static StatCounter g_numPhaseMemoHits;
+static StatCounter g_numPhaseMemoMisses;
+
+/* Host timing of the policy calls (srrip/timing_sample), by the path a miss
+ * took: invalid way, victim found at once, after 1, 2 or 3+ ageing rounds,
+ * or every candidate held by a private cache */
+enum
+{
+    MISS_PATH_INVALID = 0,
+    MISS_PATH_VICTIM,
+    MISS_PATH_AGED_1,
+    MISS_PATH_AGED_2,
+    MISS_PATH_AGED_3,
+    MISS_PATH_INCLUSION,
+    NUM_MISS_PATHS
+};
+
+static const char * const g_missPathNames[NUM_MISS_PATHS] = { "invalid", "victim", "aged1", "aged2", "aged3", "inclusion" };
+static const char * const g_hitPathNames[1] = { "hit" };
+
+static PolicyTimer g_missTimer("DBPV_DYN", "miss", NUM_MISS_PATHS, g_missPathNames);
+static PolicyTimer g_hitTimer("DBPV_DYN", "hit", 1, g_hitPathNames);
+
 CacheSetDBPV_DYN::CacheSetDBPV_DYN(
       String cfgname, core_id_t core_id,
       CacheBase::cache_t cache_type,
       UInt32 associativity, UInt32 blocksize, CacheSetInfoLRU* set_info, UInt8 num_attempts)
    : CacheSet(cache_type, associativity, blocksize)
-   , m_saturation_counter_max_value(Sim()->getCfg()->getIntArray(cfgname + "/srrip/max_value", core_id))
-   , m_db_percent_threshold(Sim()->getCfg()->getIntArray(cfgname + "/srrip/db_threshold", core_id))
-   , m_rrip_numbits(Sim()->getCfg()->getIntArray(cfgname + "/srrip/bits", core_id))
-   , m_rrip_max((1 << m_rrip_numbits) - 1)
-   , m_rrip_insert(m_rrip_max - 1)
+   , m_params(SRRIPParams::get(cfgname, core_id, associativity, num_attempts, SRRIPParams::NEEDS_DEADBLOCK))
+   , m_meta(NULL)   /* Allocated on first touch of the set */
+   , m_lifetime(NULL)
+   , m_reference(NULL)
+   , m_tune_group(TUNE_FOLLOWER)
    , m_replacement_pointer(0)
+   , m_pending_fill(associativity)
+   , m_pending_fill_evict(false)
+   , m_touched(0)
    , m_set_info(set_info)
 {
-   m_rrip_bits = new UInt8[m_associativity];
-   for (UInt32 i = 0; i < m_associativity; i++)
-      m_rrip_bits[i] = m_rrip_insert;
+    static UInt32 setID = 0;
 
-    /* To record how many times a block got hit */
-    m_block_access = new UInt8[m_associativity];
-    for (UInt8 i = 0; i < m_associativity; i++)
+    if (m_params->autotune && ((setID % m_params->tune_period) < NUM_TUNE_GROUPS))
     {
-        m_block_access[i] = 0;
+        m_tune_group = setID % m_params->tune_period;
     }
-    
-    /* To record which core brought the block into cache */
-    m_block_owner = new UInt8[m_associativity];
-    for (UInt8 i = 0; i < m_associativity; i++)
+
+    setID++;
+
+    if (m_params->lockstep_check)
     {
-        m_block_owner[i] = 0;
+        m_reference = new RRIPReference("DBPV_DYN", m_associativity, m_params->rrip_max, m_params->rrip_insert);
     }
 
     if (0 == g_iteration_count)
     {
         g_iteration_count++;
 
-        printf("\n[Newton] DBPV_DYN with associativity:%d Counter Limit:%u DB Threshold:%u!!!\n",
-                m_associativity, m_saturation_counter_max_value, m_db_percent_threshold);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksDeadC0", &g_numTotalDeadBlocksC0);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksInsC0",  &g_numTotalBlocksInsC0);
+        printf("\n[Newton] DBPV_DYN with associativity:%d Counter Limit:%u DB Threshold:%u Kernel:%s!!!\n",
+                m_associativity, m_params->saturation_counter_max_value, m_params->db_percent_threshold, m_params->kernel->name);
+        g_numTotalDeadBlocksC0.registerMetric("interval_timer", core_id, "totalBlocksDeadC0");
+        g_numTotalBlocksInsC0.registerMetric("interval_timer", core_id, "totalBlocksInsC0");
 
-        registerStatsMetric("interval_timer", core_id, "totalBlocksDeadC1", &g_numTotalDeadBlocksC1);
-        registerStatsMetric("interval_timer", core_id, "totalBlocksInsC1",  &g_numTotalBlocksInsC1);
+        g_numTotalDeadBlocksC1.registerMetric("interval_timer", core_id, "totalBlocksDeadC1");
+        g_numTotalBlocksInsC1.registerMetric("interval_timer", core_id, "totalBlocksInsC1");
 
-        registerStatsMetric("interval_timer", core_id, "InvalidBlocks",     &g_numBlocksInvalid);
-        registerStatsMetric("interval_timer", core_id, "NumTieAtEvict",     &g_numTieAtEvict);
+        g_numBlocksInvalid.registerMetric("interval_timer", core_id, "InvalidBlocks");
+        g_numTieAtEvict.registerMetric("interval_timer", core_id, "NumTieAtEvict");
         registerStatsMetric("interval_timer", core_id, "numPhases",         &g_numPhases);
+        g_numInclusionVictims.registerMetric("interval_timer", core_id, "inclusionVictims");
+        g_numInclusionSkipped.registerMetric("interval_timer", core_id, "inclusionSkipped");
+        g_numTouchedSets.registerMetric("interval_timer", core_id, "touchedSets");
+
+        for (UInt32 i = 0; i < 2; i++)
+        {
+            g_prefetchInsertMode[i] = PREFETCH_INSERT_DEMAND;
+            g_numPrefetchFills[i].registerMetric("interval_timer", core_id, String("prefetchFillsC")+itostr(i));
+            g_numPrefetchUseful[i].registerMetric("interval_timer", core_id, String("prefetchUsefulC")+itostr(i));
+            g_numPrefetchUseless[i].registerMetric("interval_timer", core_id, String("prefetchUselessC")+itostr(i));
+            g_numPrefetchBypassed[i].registerMetric("interval_timer", core_id, String("prefetchBypassedC")+itostr(i));
+        }
+
+        if (m_params->lockstep_check)
+        {
+            printf("[Newton] Lockstep check against the reference SRRIP enabled\n");
+        }
+
+        if (m_params->prefetch_aware)
+        {
+            printf("[Newton] Prefetch aware insertion, Window:%u Accuracy Threshold:%u Bypass Threshold:%u\n",
+                   m_params->prefetch_window, m_params->prefetch_accuracy_threshold, m_params->prefetch_bypass_threshold);
+        }
         
         /* Initialize the insertion locations */
-        g_core1_insert = m_rrip_insert;
-        g_core0_insert = m_rrip_insert;
+        g_core1_insert = m_params->rrip_insert;
+        g_core0_insert = m_params->rrip_insert;
+
+        g_liveDbThreshold = m_params->db_percent_threshold;
+        g_liveWindow      = m_params->saturation_counter_max_value;
+
+        if (m_params->autotune)
+        {
+            LOG_ASSERT_ERROR(m_params->tune_period > NUM_TUNE_GROUPS,
+                             "srrip/tune_period must be larger than %u", NUM_TUNE_GROUPS);
+
+            printf("[Newton] DAAIP autotune, Period:%u Epoch:%u Threshold Step:%u Margin:%u\n",
+                   m_params->tune_period, m_params->tune_epoch, m_params->tune_threshold_step,
+                   m_params->tune_margin);
+
+            for (UInt32 g = 0; g < NUM_TUNE_GROUPS; g++)
+            {
+                g_tune[g].insert[0] = g_core0_insert;
+                g_tune[g].insert[1] = g_core1_insert;
+            }
+
+            TuneCenter(m_params->tune_threshold_step);
+
+            g_tune_log = fopen(Sim()->getConfig()->formatOutputFileName("daaip_tune.log").c_str(), "w");
+            registerStatsMetric("interval_timer", core_id, "tuneDbThreshold", &g_liveDbThreshold);
+            registerStatsMetric("interval_timer", core_id, "tuneWindow",      &g_liveWindow);
+            registerStatsMetric("interval_timer", core_id, "tuneEpochs",      &g_tuneEpochs);
+        }
+
+        if (m_params->bimodal)
+        {
+            printf("[Newton] Bimodal insertion, Epsilon:%u..%u/10000 Seed:%u\n",
+                   m_params->bimodal_epsilon_min, m_params->bimodal_epsilon_max, m_params->bimodal_seed);
+
+            g_bimodal           = true;
+            g_bimodalEpsilonMin = m_params->bimodal_epsilon_min;
+            g_bimodalEpsilonMax = m_params->bimodal_epsilon_max;
+            g_bimodalEpsilon[0] = g_bimodalEpsilon[1] = m_params->bimodal_epsilon_max;
+            /* xorshift never leaves 0 */
+            g_bimodalRng        = m_params->bimodal_seed ? m_params->bimodal_seed : 1;
+
+            for (UInt32 c = 0; c < 2; c++)
+            {
+                g_numBimodalNear[c].registerMetric("interval_timer", core_id, String("bimodalNearInsertsC") + itostr(c));
+            }
+        }
+
+        if (m_params->fast_warming)
+        {
+            printf("[Newton] DBPV_DYN fast warming enabled\n");
+            PolicyWarming::enable(DAAIPWarmingHandoff);
+        }
+
+        if (m_params->sharer_aware)
+        {
+            printf("[Newton] Sharer-aware accounting enabled\n");
+            g_numSharedBlocks.registerMetric("interval_timer", core_id, "sharedBlocks");
+
+            for (UInt32 c = 0; c < 2; c++)
+            {
+                g_numCrossCoreHits[c].registerMetric("interval_timer", core_id, String("crossCoreHitsC") + itostr(c));
+                g_numSharedEvictions[c].registerMetric("interval_timer", core_id, String("sharedEvictionsC") + itostr(c));
+            }
+        }
+
+        if (m_params->lifetime_stats)
+        {
+            printf("[Newton] Block lifetime stats, Epoch:2^%u %s\n", m_params->lifetime_epoch_shift,
+                   m_params->lifetime_instructions ? "instructions" : "cycles");
+            g_lifetime.configure(m_params->lifetime_epoch_shift, m_params->lifetime_instructions);
+            g_lifetime.registerMetrics(core_id);
+        }
+
+        if (m_params->timing_sample)
+        {
+            printf("[Newton] Policy call timing, Sample:1/%u\n", m_params->timing_sample);
+            PolicyTimer::setSampling(m_params->timing_sample);
+            g_missTimer.registerMetrics(core_id);
+            g_hitTimer.registerMetrics(core_id);
+        }
+
+        if (m_params->phase_memo)
+        {
+            LOG_ASSERT_ERROR(m_params->phase_memo_sample > 0, "srrip/phase_memo_sample must be at least 1");
+
+            printf("[Newton] Phase memoization, Sample:1/%u of the window\n", m_params->phase_memo_sample);
+            g_numPhaseMemoHits.registerMetric("interval_timer", core_id, "phaseMemoHits");
+            g_numPhaseMemoMisses.registerMetric("interval_timer", core_id, "phaseMemoMisses");
+        }
         
        /* To record information about number of blocks having a particular
         * reference count */
-       for (UInt32 g_phaseID = 0; g_phaseID < NUM_PHASES; g_phaseID++)
-       {
-          for (UInt32 i = 0; i < 5; i++)
-          {
-             g_block_access_count[g_phaseID][i] = 0;
-             registerStatsMetric("interval_timer", core_id,
-                                 String("dbpv_block-access-count-")+itostr(g_phaseID)+"-"+itostr(i),
-                                 &g_block_access_count[g_phaseID][i]);
-          }
-       }
+       g_stats_core_id = core_id;
+       registerPhaseStats(g_phaseID);
        
        printf("PhaseID in progress:%u\n", g_phaseID);
        g_numPhases = g_phaseID;
@@ -132,25 +435,17 @@ CacheSetDBPV_DYN::CacheSetDBPV_DYN(
 
 CacheSetDBPV_DYN::~CacheSetDBPV_DYN()
 {
-   delete [] m_rrip_bits;
-   
+   /* m_meta belongs to the arena */
+   delete m_reference;
    for (UInt32 i = 0; i < g_iteration; i++)
    {
         printf("C0:%u C1:%u\n", g_insertionCore0[i], g_insertionCore1[i]);
    }
 }
 
-static void checkForRRIPTie(UInt8 *m_rrip_bits, UInt8 m_rrip_max, UInt8 m_associativity)
+static void checkForRRIPTie(const RRIPKernel *kernel, UInt8 *m_rrip_bits, UInt8 m_rrip_max, UInt8 m_associativity)
 {
-    UInt8 numEntriesTieArray = 0;
-    
-    for (UInt32 i = 0; i < m_associativity; i++)
-    {
-        if (m_rrip_bits[i] == m_rrip_max)
-        {
-            numEntriesTieArray++;
-        }
-    }
+    UInt32 numEntriesTieArray = __builtin_popcountll(kernel->maxMask(m_rrip_bits, m_associativity, m_rrip_max));
     
     if (numEntriesTieArray > 1)
     {
@@ -171,17 +466,17 @@ void UpdateBlockInsertionLocation(UInt32 m_saturation_counter_max_value,
     UInt32 db_percent_c0 = 0;
     UInt32 db_percent_c1 = 0;
 
-    printf("\nUpdatingInsertionLocation:InvBlks=%lu", g_numBlocksInvalid);
+    printf("\nUpdatingInsertionLocation:InvBlks=%lu", g_numBlocksInvalid.get());
 
-    printf("\nDT_c0:%lu, DV_c0:%u, InT_c0:%lu, InV_c0:%u, DT_c1:%lu, DV_c1:%u, InT_c1:%lu, InV_c1:%u",
-           g_numTotalDeadBlocksC0, g_ValidDeadBlocksC0, g_numTotalBlocksInsC0, g_InsValidBlocksC0,
-           g_numTotalDeadBlocksC1, g_ValidDeadBlocksC1, g_numTotalBlocksInsC1, g_InsValidBlocksC1);
+    printf("\nDT_c0:%lu, DV_c0:%lu, InT_c0:%lu, InV_c0:%lu, DT_c1:%lu, DV_c1:%lu, InT_c1:%lu, InV_c1:%lu",
+           g_numTotalDeadBlocksC0.get(), g_ValidDeadBlocksC0, g_numTotalBlocksInsC0.get(), g_InsValidBlocksC0,
+           g_numTotalDeadBlocksC1.get(), g_ValidDeadBlocksC1, g_numTotalBlocksInsC1.get(), g_InsValidBlocksC1);
 
     /* Check if all the cache lines have been filled, cache has been warmed */
     /* Calculate the percent of dead blocks for each application */
     if (0 == coreID)
     {
-        if (g_InsValidBlocksC0 == m_saturation_counter_max_value)
+        if (g_InsValidBlocksC0 >= m_saturation_counter_max_value)
         {
             db_percent_c0 = (10000 * g_ValidDeadBlocksC0 / g_InsValidBlocksC0);
             printf("\nDeadBlockC0_Per:%d", db_percent_c0);
@@ -189,24 +484,28 @@ void UpdateBlockInsertionLocation(UInt32 m_saturation_counter_max_value,
         
         if (db_percent_c0 >= m_db_percent_threshold)
         {
-            g_core0_insert = m_rrip_max;
             printf("\nCore0InsertedAt:%d", m_rrip_max);
-
-            /* If core 1 is already at RRIP MAX, then insert core 0 at 2 even if it
-             * has deadblocks more than threshold, so that atleast core 0 is able to
-             * utilize cache */
-            g_core0_insert = (g_core1_insert == m_rrip_max) ? m_rrip_insert : m_rrip_max;
         }
         else
         {
              printf("\nReverting C0 Back to RRIP 2");
-             g_core0_insert = m_rrip_insert;
+        }
+
+        /* Bimodal insertion leaves both cores a foothold, so there both
+         * may be at rrip_max */
+        g_core0_insert = DAAIPInsertion(db_percent_c0 >= m_db_percent_threshold, g_core1_insert,
+                                        m_rrip_max, m_rrip_insert, !g_bimodal);
+
+        if (g_bimodal)
+        {
+            g_bimodalEpsilon[0] = BimodalEpsilon(db_percent_c0, m_db_percent_threshold);
+            printf("\nC0BimodalEpsilon:%u", g_bimodalEpsilon[0]);
         }
     }
     
     if (1 == coreID)
     {
-        if (g_InsValidBlocksC1 == m_saturation_counter_max_value)
+        if (g_InsValidBlocksC1 >= m_saturation_counter_max_value)
         {
             db_percent_c1 = (10000 * g_ValidDeadBlocksC1 / g_InsValidBlocksC1);
             printf("\nDeadBlockC1_Per:%d", db_percent_c1);
@@ -214,15 +513,20 @@ void UpdateBlockInsertionLocation(UInt32 m_saturation_counter_max_value,
     
         if (db_percent_c1 >= m_db_percent_threshold)
         {
-            g_core1_insert = m_rrip_max;
             printf("\nCore1InsertedAt:%d", m_rrip_max);
-        
-            g_core1_insert = (g_core0_insert == m_rrip_max) ? m_rrip_insert : m_rrip_max;
         }
         else
         {
              printf("\nReverting C1 Back to RRIP 2");
-             g_core1_insert = m_rrip_insert;
+        }
+
+        g_core1_insert = DAAIPInsertion(db_percent_c1 >= m_db_percent_threshold, g_core0_insert,
+                                        m_rrip_max, m_rrip_insert, !g_bimodal);
+
+        if (g_bimodal)
+        {
+            g_bimodalEpsilon[1] = BimodalEpsilon(db_percent_c1, m_db_percent_threshold);
+            printf("\nC1BimodalEpsilon:%u", g_bimodalEpsilon[1]);
         }
     }
 
@@ -239,97 +543,511 @@ void UpdateBlockInsertionLocation(UInt32 m_saturation_counter_max_value,
     g_insertionCore0[g_iteration] = g_core0_insert;
     g_insertionCore1[g_iteration] = g_core1_insert;
 }
-    
-UInt32
-CacheSetDBPV_DYN::InsertBlockAtIndex(UInt32 index, core_id_t core_id)
+
+/* Place the neighbour groups around the live parameters and start a new
+ * epoch. The windows and insertion positions of the groups carry on. */
+static void TuneCenter(UInt32 threshold_step)
 {
-    /* When we found a victim block, we are finding how many blocks have
-     * same RRPV value
-     */
-    checkForRRIPTie(m_rrip_bits, m_rrip_max, m_associativity);
+    for (UInt32 g = 0; g < NUM_TUNE_GROUPS; g++)
+    {
+        g_tune[g].db_threshold = g_liveDbThreshold;
+        g_tune[g].window       = g_liveWindow;
+        g_tune[g].misses       = 0;
+    }
 
-    m_replacement_pointer = (m_replacement_pointer + 1) % m_associativity;
+    g_tune[1].db_threshold = (g_liveDbThreshold > threshold_step) ? g_liveDbThreshold - threshold_step : 0;
+    g_tune[2].db_threshold = (g_liveDbThreshold + threshold_step < 10000) ? g_liveDbThreshold + threshold_step : 10000;
+    g_tune[3].window       = (g_liveWindow / 2 > TUNE_MIN_WINDOW) ? g_liveWindow / 2 : TUNE_MIN_WINDOW;
+    g_tune[4].window       = 2 * g_liveWindow;
+}
 
-    LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate");
+/* Demand fill after an eviction in a leader group: same rule as the live
+ * window in UpdateBlockInsertionLocation, on the group's counters and
+ * scaled to the share of the sets the group holds */
+static void TuneGroupFill(DAAIPTuneGroup &group, UInt32 core, UInt32 tune_period,
+                          UInt8 rrip_max, UInt8 rrip_insert)
+{
+    UInt32 window = group.window / tune_period;
+    UInt32 db_percent;
 
-    /* Increment the number of access a block gets. We are trying to figure out
-     * how many blocks are getting a particular access */
+    if (window < TUNE_MIN_GROUP_WINDOW)
+    {
+        window = TUNE_MIN_GROUP_WINDOW;
+    }
+
+    if (!DAAIPWindowFill(group.ins[core], group.dead[core], window, db_percent))
     {
-        UInt32 a = m_block_access[index];
+        return;
+    }
+
+    group.insert[core] = DAAIPInsertion(db_percent >= group.db_threshold, group.insert[1 - core],
+                                        rrip_max, rrip_insert, !g_bimodal);
+}
+
+static void TuneEpoch(UInt32 threshold_step, UInt32 margin)
+{
+    UInt32 best = TUNE_CONTROL;
+    UInt64 control = g_tune[TUNE_CONTROL].misses;
 
-        /* When a >= 10, we are storing the accesses in 10 */
-        if (a >= 4)
+    for (UInt32 g = 0; g < NUM_TUNE_GROUPS; g++)
+    {
+        if (g_tune[g].misses < g_tune[best].misses)
         {
-            a = 4;
+            best = g;
         }
-         
-        g_block_access_count[g_phaseID][a]++;
     }
 
-    /* Find if the victim block is dead blocks */
-    if (0 == m_block_access[index])
+    /* A difference within the margin is taken as noise */
+    if (10000 * (control - g_tune[best].misses) <= (UInt64)margin * control)
     {
-        /* Block is dead, findout who was its owner */
-        (0 == m_block_owner[index]) ? g_numTotalDeadBlocksC0++ : g_numTotalDeadBlocksC1++;
-        (0 == m_block_owner[index]) ? g_ValidDeadBlocksC0++  : g_ValidDeadBlocksC1++;
+        best = TUNE_CONTROL;
     }
 
-    /* Prepare way for a new line: set prediction to 'long' */
+    if (g_tune_log)
+    {
+        fprintf(g_tune_log, "epoch=%lu cycles=%lu db_threshold=%lu window=%lu misses=",
+                g_tuneEpochs, g_cycles_count, g_liveDbThreshold, g_liveWindow);
+        for (UInt32 g = 0; g < NUM_TUNE_GROUPS; g++)
+            fprintf(g_tune_log, "%s%lu", g ? "," : "", g_tune[g].misses);
+        fprintf(g_tune_log, " best=%u next_db_threshold=%u next_window=%u\n",
+                best, g_tune[best].db_threshold, g_tune[best].window);
+        fflush(g_tune_log);
+    }
+
+    if (TUNE_CONTROL != best)
+    {
+        printf("\n[Newton] DAAIP autotune: db_threshold %lu -> %u, window %lu -> %u\n",
+               g_liveDbThreshold, g_tune[best].db_threshold, g_liveWindow, g_tune[best].window);
+    }
+
+    g_liveDbThreshold = g_tune[best].db_threshold;
+    g_liveWindow      = g_tune[best].window;
+    g_tuneEpochs++;
+
+    TuneCenter(threshold_step);
+}
+
+static UInt32 PhaseSignature(UInt32 core, UInt64 dead, UInt64 fills)
+{
+    UInt64 dead_q = (8 * dead) / fills;
+    UInt64 hit_q  = 63 - __builtin_clzll(1 + (4 * g_windowHits[core]) / fills);
+    UInt64 pf_q   = (4 * g_windowPrefetchFills[core]) / fills;
+
+    dead_q = (dead_q > 7) ? 7 : dead_q;
+    hit_q  = (hit_q > 7)  ? 7 : hit_q;
+    pf_q   = (pf_q > 3)   ? 3 : pf_q;
+
+    return dead_q | (hit_q << 3) | (pf_q << 6);
+}
+
+/* Sample point of the window of core: take the signature and, if the
+ * phase is known, its insertion position. Same rule as the live window,
+ * only one core may be at rrip_max. */
+static void PhaseMemoSample(UInt32 core, UInt64 dead, UInt64 fills, UInt8 rrip_max, UInt8 rrip_insert)
+{
+    UInt32 sig = PhaseSignature(core, dead, fills);
+    const PhaseMemoEntry &entry = g_phaseMemo[core][sig];
+
+    g_phaseSig[core] = sig;
+
+    if (entry.confidence < PHASE_MEMO_CONFIDENCE)
+    {
+        g_numPhaseMemoMisses++;
+        return;
+    }
+
+    UInt8 &insert = (0 == core) ? g_core0_insert : g_core1_insert;
+    UInt8  other  = (0 == core) ? g_core1_insert : g_core0_insert;
+
+    insert = DAAIPInsertion(entry.insert == rrip_max, other, rrip_max, rrip_insert, !g_bimodal);
+    g_numPhaseMemoHits++;
+
+    printf("\n[Newton] PhaseMemo C%u Sig:%#x InsertedAt:%u", core, sig, insert);
+}
+
+/* End of the window of core: remember what the full window decided for
+ * the signature taken at its sample point */
+static void PhaseMemoLearn(UInt32 core, UInt8 insert)
+{
+    if (PHASE_SIG_NONE != g_phaseSig[core])
+    {
+        PhaseMemoEntry &entry = g_phaseMemo[core][g_phaseSig[core]];
+
+        if ((entry.confidence > 0) && (entry.insert == insert))
+        {
+            entry.confidence += (entry.confidence < PHASE_MEMO_MAX_CONFIDENCE) ? 1 : 0;
+        }
+        else
+        {
+            entry.insert     = insert;
+            entry.confidence = 1;
+        }
+    }
+
+    g_phaseSig[core]            = PHASE_SIG_NONE;
+    g_windowHits[core]          = 0;
+    g_windowPrefetchFills[core] = 0;
+}
+
+/* Switch from warming to detailed mode (srrip/fast_warming): the windows,
+ * the tuner epoch and the prefetch accuracy windows start empty, the
+ * insertion positions and the live parameters carry over */
+static void DAAIPWarmingHandoff()
+{
+    g_InsValidBlocksC0  = g_InsValidBlocksC1  = 0;
+    g_ValidDeadBlocksC0 = g_ValidDeadBlocksC1 = 0;
+
+    for (UInt32 c = 0; c < 2; c++)
+    {
+        g_windowHits[c]           = 0;
+        g_windowPrefetchFills[c]  = 0;
+        g_prefetchUsefulWindow[c] = 0;
+        g_prefetchDoneWindow[c]   = 0;
+    }
+
+    for (UInt32 g = 0; g < NUM_TUNE_GROUPS; g++)
+    {
+        g_tune[g].ins[0]  = g_tune[g].ins[1]  = 0;
+        g_tune[g].dead[0] = g_tune[g].dead[1] = 0;
+        g_tune[g].misses  = 0;
+    }
+
+    g_tuneLeaderMisses = 0;
+}
+
+/* Insertion RRPV of a demand fill of core 0 or 1. A pending fill may still
+ * turn out to be a prefetch, so its bimodal draw is left to
+ * ResolvePendingFill. */
+UInt8
+CacheSetDBPV_DYN::DemandInsertion(core_id_t core_id, bool pending)
+{
+    UInt8 insert = IsTuneLeader() ? g_tune[m_tune_group].insert[core_id]
+                                     : ((0 == core_id) ? g_core0_insert : g_core1_insert);
+
+    return pending ? insert : BimodalInsertion(core_id, insert);
+}
+
+/* Bimodal insertion of a demand fill at rrip_max. Leader groups of the
+ * tuner draw with the live epsilon of the core. */
+UInt8
+CacheSetDBPV_DYN::BimodalInsertion(core_id_t core_id, UInt8 insert)
+{
+    if (g_bimodal && (insert == m_params->rrip_max) && (BimodalDraw() < g_bimodalEpsilon[core_id]))
+    {
+        if (!PolicyWarming::isWarming())
+        {
+            g_numBimodalNear[core_id]++;
+        }
+
+        return m_params->rrip_insert;
+    }
+
+    return insert;
+}
+
+/* First access to the set: take its arrays from the arena, a fresh chunk
+ * is zeroed, only the RRPVs need their initial value */
+void
+CacheSetDBPV_DYN::AllocateMeta()
+{
+    m_meta = SetMetaArena::get(META_ARRAYS * m_associativity)->allocate();
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        rripBits()[i] = m_params->rrip_insert;
+    }
+
+    if (m_params->lifetime_stats)
+    {
+        m_lifetime = g_lifetime.allocate(m_associativity);
+    }
+
+    g_numTouchedSets++;
+}
+
+/* A prefetched block is useful if it gets a hit before eviction. After every
+ * prefetch_window resolved prefetches of a core, its accuracy decides where
+ * the next prefetches of that core are inserted.
+ */
+static void UpdatePrefetchInsertion(UInt8 coreID, bool useful, UInt32 window,
+                                    UInt32 accuracy_threshold, UInt32 bypass_threshold)
+{
+    UInt32 accuracy;
+    UInt8  mode;
+
+    useful ? g_numPrefetchUseful[coreID]++ : g_numPrefetchUseless[coreID]++;
+
+    if (useful)
+    {
+        g_prefetchUsefulWindow[coreID]++;
+    }
+
+    if (++g_prefetchDoneWindow[coreID] < window)
+    {
+        return;
+    }
+
+    accuracy = (10000 * g_prefetchUsefulWindow[coreID] / g_prefetchDoneWindow[coreID]);
+
+    if (accuracy < bypass_threshold)
+    {
+        mode = PREFETCH_BYPASS;
+    }
+    else if (accuracy < accuracy_threshold)
+    {
+        mode = PREFETCH_INSERT_DISTANT;
+    }
+    else
+    {
+        mode = PREFETCH_INSERT_DEMAND;
+    }
+
+    if (mode != g_prefetchInsertMode[coreID])
+    {
+        printf("\nPrefetchC%u Accuracy:%u InsertionMode:%u->%u\n",
+               coreID, accuracy, g_prefetchInsertMode[coreID], mode);
+    }
+
+    g_prefetchInsertMode[coreID]   = mode;
+    g_prefetchUsefulWindow[coreID] = 0;
+    g_prefetchDoneWindow[coreID]   = 0;
+}
+
+/* Insertion statistics of a demand fill; evicted is false when the fill went
+ * to an invalid way, which does not count towards the phase window */
+void
+CacheSetDBPV_DYN::RecordDemandFill(UInt32 index, core_id_t core_id, bool evicted)
+{
     if (core_id == 0)
     {
-        m_rrip_bits[index] = g_core0_insert;
         g_numTotalBlocksInsC0++;
-        g_InsValidBlocksC0++;
     }
     else if (core_id == 1)
     {
-        m_rrip_bits[index] = g_core1_insert;
         g_numTotalBlocksInsC1++;
-        g_InsValidBlocksC1++;
     }
     else
     {
         printf("\n\n\n[Newton]ERROR!!!!\n\n\n");
+        return;
     }
-    
-    /* Reset its access counters */
-    m_block_access[index] = 0;
-    m_block_owner[index] = core_id;
 
-    if (g_InsValidBlocksC0 == m_saturation_counter_max_value)
-     printf("\nID:%u InsertedC0:%d, DeadC0:%d", g_phaseID, g_InsValidBlocksC0, g_ValidDeadBlocksC0);   
+    if (!evicted)
+    {
+        return;
+    }
+
+    /* Leader groups of the tuner run their own window */
+    if (IsTuneLeader())
+    {
+        TuneGroupFill(g_tune[m_tune_group], core_id, m_params->tune_period,
+                      m_params->rrip_max, m_params->rrip_insert);
+        return;
+    }
+
+    (0 == core_id) ? g_InsValidBlocksC0++ : g_InsValidBlocksC1++;
+
+    if (m_params->phase_memo)
+    {
+        UInt64 fills  = (0 == core_id) ? g_InsValidBlocksC0  : g_InsValidBlocksC1;
+        UInt64 dead   = (0 == core_id) ? g_ValidDeadBlocksC0 : g_ValidDeadBlocksC1;
+        UInt64 sample = g_liveWindow / m_params->phase_memo_sample;
+
+        if (fills == ((sample > 0) ? sample : 1))
+        {
+            PhaseMemoSample(core_id, dead, fills, m_params->rrip_max, m_params->rrip_insert);
+        }
+    }
+
+    if (g_InsValidBlocksC0 == g_liveWindow)
+     printf("\nID:%u InsertedC0:%lu, DeadC0:%lu", g_phaseID, g_InsValidBlocksC0, g_ValidDeadBlocksC0);   
 
-    if (g_InsValidBlocksC1 == m_saturation_counter_max_value)
-     printf("\nID:%u InsertedC1:%d, DeadC1:%d", g_phaseID, g_InsValidBlocksC1, g_ValidDeadBlocksC1);   
+    if (g_InsValidBlocksC1 == g_liveWindow)
+     printf("\nID:%u InsertedC1:%lu, DeadC1:%lu", g_phaseID, g_InsValidBlocksC1, g_ValidDeadBlocksC1);   
 
-    if (m_saturation_counter_max_value == g_InsValidBlocksC1)
+    /* >=, the tuner may shrink the window below the current count */
+    if (g_InsValidBlocksC1 >= g_liveWindow)
     {
-        UpdateBlockInsertionLocation(m_saturation_counter_max_value,
-                                     m_db_percent_threshold, m_rrip_max, m_rrip_insert, 1);
+        UpdateBlockInsertionLocation(g_liveWindow, g_liveDbThreshold,
+                                     m_params->rrip_max, m_params->rrip_insert, 1);
+        PhaseMemoLearn(1, g_core1_insert);
         /* To get more accurate data about phase-wise deadblock percentage, resetting
          * to zero will be fine */
         g_InsValidBlocksC1  = 0;
         g_ValidDeadBlocksC1 = 0;
         g_phaseID++;
+        registerPhaseStats(g_phaseID);
         printf("PhaseID in progress:%u\n", g_phaseID);
     }
 
-    if (m_saturation_counter_max_value == g_InsValidBlocksC0)
+    if (g_InsValidBlocksC0 >= g_liveWindow)
     {
-        UpdateBlockInsertionLocation(m_saturation_counter_max_value,
-                                     m_db_percent_threshold, m_rrip_max, m_rrip_insert, 0);
+        UpdateBlockInsertionLocation(g_liveWindow, g_liveDbThreshold,
+                                     m_params->rrip_max, m_params->rrip_insert, 0);
+        PhaseMemoLearn(0, g_core0_insert);
         g_InsValidBlocksC0  = 0;
         g_ValidDeadBlocksC0 = 0;
         g_phaseID++;
+        registerPhaseStats(g_phaseID);
         printf("PhaseID in progress:%u\n", g_phaseID);
     }
     
     g_numPhases = g_phaseID;
+}
+
+/* Sniper marks a block as prefetched only after it has been inserted, so the
+ * fill is classified on the next access to the set. Nothing else touches the
+ * set in between, hence placing a prefetch at its RRPV here is the same as
+ * placing it at fill time.
+ */
+void
+CacheSetDBPV_DYN::ResolvePendingFill()
+{
+    UInt32 index = m_pending_fill;
+    UInt8  owner;
+
+    if (index >= m_associativity)
+    {
+        return;
+    }
+
+    m_pending_fill = m_associativity;
+    owner = blockOwner()[index];
+
+    if ((owner < 2) && m_cache_block_info_array[index]->isValid()
+        && m_cache_block_info_array[index]->hasOption(CacheBlockInfo::PREFETCH))
+    {
+        blockPrefetch()[index] = 1;
+        g_numPrefetchFills[owner]++;
+
+        if (!IsTuneLeader())
+        {
+            g_windowPrefetchFills[owner]++;
+        }
+
+        if (PREFETCH_INSERT_DISTANT == g_prefetchInsertMode[owner])
+        {
+            rripBits()[index] = m_params->rrip_max;
+        }
+        else if (PREFETCH_BYPASS == g_prefetchInsertMode[owner])
+        {
+            /* The set cannot refuse the fill, the block is made the very next
+             * victim instead */
+            rripBits()[index] = m_params->rrip_max;
+            m_replacement_pointer = index;
+            g_numPrefetchBypassed[owner]++;
+        }
+
+        if (m_reference)
+        {
+            m_reference->setRRPV(index, rripBits()[index]);
+            m_reference->setPointer(m_replacement_pointer);
+        }
+    }
+    else
+    {
+        /* A demand fill after all: it takes its bimodal draw now */
+        if (owner < 2)
+        {
+            rripBits()[index] = BimodalInsertion(owner, rripBits()[index]);
+
+            if (m_reference)
+            {
+                m_reference->setRRPV(index, rripBits()[index]);
+            }
+        }
+
+        RecordDemandFill(index, owner, m_pending_fill_evict);
+    }
+}
+
+UInt32
+CacheSetDBPV_DYN::InsertBlockAtIndex(UInt32 index, core_id_t core_id)
+{
+    /* When we found a victim block, we are finding how many blocks have
+     * same RRPV value
+     */
+    checkForRRIPTie(m_params->kernel, rripBits(), m_params->rrip_max, m_associativity);
+
+    m_replacement_pointer = (m_replacement_pointer + 1) % m_associativity;
+
+    LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate");
+
+    /* Increment the number of access a block gets. We are trying to figure out
+     * how many blocks are getting a particular access */
+    {
+        UInt32 a = blockAccess()[index];
+
+        /* When a >= 4, we are storing the accesses in 4 */
+        if (a >= NUM_ACCESS_BUCKETS - 1)
+        {
+            a = NUM_ACCESS_BUCKETS - 1;
+        }
+         
+        /* Phases past NUM_PHASES accumulate in the last one */
+        g_block_access_count[(g_phaseID < NUM_PHASES) ? g_phaseID : NUM_PHASES - 1][a]++;
+    }
+
+    /* Find if the victim block is dead blocks */
+    if (blockPrefetch()[index])
+    {
+        /* Prefetched block evicted without a hit, it does not count as a
+         * demand dead block */
+        UpdatePrefetchInsertion(blockOwner()[index], false, m_params->prefetch_window,
+                                m_params->prefetch_accuracy_threshold, m_params->prefetch_bypass_threshold);
+    }
+    else if (0 == blockAccess()[index])
+    {
+        /* Block is dead, findout who was its owner */
+        (0 == blockOwner()[index]) ? g_numTotalDeadBlocksC0++ : g_numTotalDeadBlocksC1++;
+
+        if (IsTuneLeader())
+        {
+            g_tune[m_tune_group].dead[(0 == blockOwner()[index]) ? 0 : 1]++;
+        }
+        else
+        {
+            (0 == blockOwner()[index]) ? g_ValidDeadBlocksC0++  : g_ValidDeadBlocksC1++;
+        }
+    }
+
+    if (isShared(index) && (blockOwner()[index] < 2))
+    {
+        g_numSharedEvictions[blockOwner()[index]]++;
+    }
+
+    if (m_lifetime)
+    {
+        g_lifetime.evict(m_lifetime, m_associativity, index, blockOwner()[index]);
+        g_lifetime.fill(m_lifetime, m_associativity, index);
+    }
+
+    /* Prepare way for a new line: set prediction to 'long' */
+    if ((core_id == 0) || (core_id == 1))
+    {
+        rripBits()[index] = DemandInsertion(core_id, m_params->prefetch_aware);
+    }
+    
+    /* Reset its access counters */
+    blockAccess()[index]   = 0;
+    blockOwner()[index]    = core_id;
+    blockPrefetch()[index] = 0;
+    blockSharers()[index]  = 1 << (core_id % 8);
+
+    if (m_params->prefetch_aware)
+    {
+        m_pending_fill       = index;
+        m_pending_fill_evict = true;
+    }
+    else
+    {
+        RecordDemandFill(index, core_id, true);
+    }
 
     #if 0
-    printf("\nDT_c0:%lu, DV_c0:%u, InT_c0:%lu, InV_c0:%u, DT_c1:%lu, DV_c1:%u, InT_c1:%lu, InV_c1:%u, coreID:%d",
-           g_numTotalDeadBlocksC0, g_ValidDeadBlocksC0, g_numTotalBlocksInsC0, g_InsValidBlocksC0,
-           g_numTotalDeadBlocksC1, g_ValidDeadBlocksC1, g_numTotalBlocksInsC1, g_InsValidBlocksC1,
+    printf("\nDT_c0:%lu, DV_c0:%lu, InT_c0:%lu, InV_c0:%lu, DT_c1:%lu, DV_c1:%lu, InT_c1:%lu, InV_c1:%lu, coreID:%d",
+           g_numTotalDeadBlocksC0.get(), g_ValidDeadBlocksC0, g_numTotalBlocksInsC0.get(), g_InsValidBlocksC0,
+           g_numTotalDeadBlocksC1.get(), g_ValidDeadBlocksC1, g_numTotalBlocksInsC1.get(), g_InsValidBlocksC1,
            core_id);
     #endif
     
@@ -340,6 +1058,123 @@ CacheSetDBPV_DYN::InsertBlockAtIndex(UInt32 index, core_id_t core_id)
 UInt32
 CacheSetDBPV_DYN::getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id)
 {
+    if (PolicyWarming::isWarming())
+    {
+        touchMeta();
+        return WarmReplacementIndex(core_id);
+    }
+
+    UInt64 tsc = PolicyTimer::start();
+    UInt32 path, index;
+
+    touchMeta();
+    ResolvePendingFill();
+    ApplyDeferredHits();
+
+    if (TUNE_FOLLOWER != m_tune_group)
+    {
+        g_tune[m_tune_group].misses++;
+
+        if (++g_tuneLeaderMisses >= m_params->tune_epoch)
+        {
+            g_tuneLeaderMisses = 0;
+            TuneEpoch(m_params->tune_threshold_step, m_params->tune_margin);
+        }
+    }
+
+    if (NULL == m_reference)
+    {
+        index = FindReplacementIndex(cntlr, core_id, path);
+    }
+    else
+    {
+        UInt32 expected = m_reference->getReplacementIndex(cntlr, m_cache_block_info_array, m_params->num_attempts);
+        index = FindReplacementIndex(cntlr, core_id, path);
+
+        /* The insertion position is the policy's decision, not part of the check */
+        m_reference->setRRPV(index, rripBits()[index]);
+        m_reference->check("getReplacementIndex", expected, index, rripBits(), m_replacement_pointer);
+    }
+
+    g_missTimer.stop(tsc, path);
+
+    return index;
+}
+
+/* Miss while warming: the victim search and fill of FindReplacementIndex
+ * and InsertBlockAtIndex, without statistics, window accounting, prefetch
+ * classification of the warm fills or private cache queries */
+UInt32
+CacheSetDBPV_DYN::WarmReplacementIndex(core_id_t core_id)
+{
+    UInt32 index = m_associativity;
+
+    /* A fill left pending by detailed mode is still classified there */
+    ResolvePendingFill();
+    ApplyDeferredHits();
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        if (!m_cache_block_info_array[i]->isValid())
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (m_associativity == index)
+    {
+        UInt64 candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+
+        if (0 == candidates)
+        {
+            m_params->kernel->age(rripBits(), m_associativity, m_params->rrip_max);
+            candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+        }
+
+        while (candidates)
+        {
+            UInt32 way = nextWayInMask(candidates, m_replacement_pointer);
+
+            if (isValidReplacement(way))
+            {
+                index = way;
+                break;
+            }
+
+            candidates &= ~(UInt64(1) << way);
+        }
+
+        LOG_ASSERT_ERROR(index < m_associativity, "SRRIP found no replaceable way while warming");
+
+        m_replacement_pointer = (index + 1) % m_associativity;
+    }
+
+    if ((core_id == 0) || (core_id == 1))
+    {
+        rripBits()[index] = DemandInsertion(core_id, false);
+    }
+
+    blockAccess()[index]   = 0;
+    blockOwner()[index]    = core_id;
+    blockPrefetch()[index] = 0;
+    blockSharers()[index]  = 1 << (core_id % 8);
+
+    /* No histogram update, but the block carries its fill epoch into
+     * detailed mode */
+    if (m_lifetime)
+    {
+        g_lifetime.fill(m_lifetime, m_associativity, index);
+    }
+
+    return index;
+}
+
+UInt32
+CacheSetDBPV_DYN::FindReplacementIndex(CacheCntlr *cntlr, core_id_t core_id, UInt32 &path)
+{
+    path = MISS_PATH_INVALID;
+
     for (UInt32 i = 0; i < m_associativity; i++)
     {
         if (!m_cache_block_info_array[i]->isValid())
@@ -348,78 +1183,250 @@ CacheSetDBPV_DYN::getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id)
              * of other lines, we choose the first invalid line to replace
              * Prepare way for a new line: set prediction to 'long'
              */
-            if (core_id == 0)
+            if ((core_id == 0) || (core_id == 1))
+            {
+                rripBits()[i] = DemandInsertion(core_id, m_params->prefetch_aware);
+            }
+
+            /* Reset its access counters */
+            blockAccess()[i]   = 0;
+            blockOwner()[i]    = core_id;
+            blockPrefetch()[i] = 0;
+            blockSharers()[i]  = 1 << (core_id % 8);
+            
+            g_numBlocksInvalid++;
+
+            if (m_lifetime)
             {
-                m_rrip_bits[i] = g_core0_insert;
-                g_numTotalBlocksInsC0++;
+                g_lifetime.fill(m_lifetime, m_associativity, i);
             }
-            else if (core_id == 1)
+
+            if (m_params->prefetch_aware)
             {
-                m_rrip_bits[i] = g_core1_insert;
-                g_numTotalBlocksInsC1++;
+                m_pending_fill       = i;
+                m_pending_fill_evict = false;
             }
             else
             {
-                printf("\n\n\n[Newton]ERROR!!!!\n\n\n");
+                RecordDemandFill(i, core_id, false);
             }
-
-            /* Reset its access counters */
-            m_block_access[i] = 0;
-            m_block_owner[i]  = core_id;
-            
-            g_numBlocksInvalid++;
          
             return i;
         }
     }
 
-   for(UInt32 j = 0; j <= m_rrip_max; ++j)
+   UInt32 num_queries = 0;
+   UInt32 inclusion_victim = m_associativity;
+   UInt64 candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+
+   path = MISS_PATH_VICTIM;
+
+   /* Increment all RRIP counters until one hits RRIP_MAX */
+   if (0 == candidates)
    {
-      for (UInt32 i = 0; i < m_associativity; i++)
-      {
-         if (m_rrip_bits[m_replacement_pointer] >= m_rrip_max)
-         {
-            /* We choose the first non-touched line as the victim (note that we
-             * start searching from the replacement pointer position)
-             */
-            return InsertBlockAtIndex(m_replacement_pointer, core_id);
-         }
+      /* Every way is aged by the same number of rounds */
+      UInt8 before = rripBits()[0];
 
-         m_replacement_pointer = (m_replacement_pointer + 1) % m_associativity;
-     }
+      m_params->kernel->age(rripBits(), m_associativity, m_params->rrip_max);
+      candidates = m_params->kernel->maxMask(rripBits(), m_associativity, m_params->rrip_max);
+
+      path = MISS_PATH_AGED_1 + ((rripBits()[0] - before < 3) ? rripBits()[0] - before : 3) - 1;
+   }
+
+   /* We choose the first non-touched line as the victim (note that we
+    * start searching from the replacement pointer position)
+    */
+   for (UInt64 remaining = candidates; remaining; )
+   {
+      UInt32 index = nextWayInMask(remaining, m_replacement_pointer);
 
-      /* Increment all RRIP counters until one hits RRIP_MAX */
-      for (UInt32 i = 0; i < m_associativity; i++)
+      if (!IsInclusionVictim(cntlr, index, num_queries))
       {
-         if (m_rrip_bits[i] < m_rrip_max)
-         {
-            m_rrip_bits[i]++;
-         }
+         m_replacement_pointer = index;
+         return InsertBlockAtIndex(index, core_id);
       }
+
+      /* Line is still held by a private cache, keep looking for another
+       * line at rrip_max and fall back to this one */
+      if (m_associativity == inclusion_victim)
+      {
+         inclusion_victim = index;
+      }
+
+      remaining &= ~(UInt64(1) << index);
+   }
+
+   /* Every line at rrip_max is present in a private cache: evict the
+    * first one rather than ageing the rest of the set */
+   if (inclusion_victim < m_associativity)
+   {
+      g_numInclusionVictims++;
+      path = MISS_PATH_INCLUSION;
+      m_replacement_pointer = inclusion_victim;
+      return InsertBlockAtIndex(inclusion_victim, core_id);
    }
 
    LOG_PRINT_ERROR("Error finding replacement index");
 }
 
+/* Query based selection (TLA): evicting a line from the inclusive LLC while
+ * a private cache holds it forces a back-invalidation and a later re-miss.
+ * With srrip/qbs_attempts = N, up to N - 1 candidates per miss are checked
+ * through the controller and skipped if present above. Candidates accepted
+ * without a query are checked only when srrip/inclusion_stats is set, so the
+ * number of inclusion victims can also be measured without avoidance.
+ */
+bool
+CacheSetDBPV_DYN::IsInclusionVictim(CacheCntlr *cntlr, UInt32 index, UInt32 &num_queries)
+{
+    if (NULL == cntlr)
+    {
+        return false;
+    }
+
+    if (num_queries + 1 < m_params->num_attempts)
+    {
+        num_queries++;
+
+        if (cntlr->isInLowerLevelCache(m_cache_block_info_array[index]))
+        {
+            g_numInclusionSkipped++;
+            return true;
+        }
+
+        return false;
+    }
+
+    if (m_params->inclusion_stats && cntlr->isInLowerLevelCache(m_cache_block_info_array[index]))
+    {
+        g_numInclusionVictims++;
+    }
+
+    return false;
+}
+
 void
-CacheSetDBPV_DYN::updateReplacementIndex(UInt32 accessed_index)
+CacheSetDBPV_DYN::PromoteBlock(UInt32 index)
 {
     /* If block access count have reached saturation limit MAX_BLOCK_COUNT,
      * keep the counter saturated.
      */
-    if (MAX_BLOCK_COUNT != m_block_access[accessed_index])
+    if (MAX_BLOCK_COUNT != blockAccess()[index])
     {
-        m_block_access[accessed_index]++;
+        blockAccess()[index]++;
     }
     
    /* As per SRRIP paper, SRRIP-HP performs better than SRRIP-FP, hence
     * setting the RRPV values directly to 0 is more beneficial than
     * decreasing it slowly.
     */ 
-    if (m_rrip_bits[accessed_index] > 0)
+    if (rripBits()[index] > 0)
+    {
+        rripBits()[index] = 0;
+    }
+
+    if (m_reference)
+    {
+        m_reference->hit(index);
+        m_reference->check("updateReplacementIndex", index, index, rripBits(), m_replacement_pointer);
+    }
+}
+
+/* Promotions of the hits since the last miss. Same state as promoting on
+ * every hit: the access counter is one bit and the RRPV goes straight to 0,
+ * so further hits to a touched way change nothing. */
+void
+CacheSetDBPV_DYN::ApplyDeferredHits()
+{
+    for (UInt64 touched = m_touched; touched; touched &= touched - 1)
+    {
+        PromoteBlock(__builtin_ctzll(touched));
+    }
+
+    m_touched = 0;
+}
+
+void
+CacheSetDBPV_DYN::updateReplacementIndex(UInt32 accessed_index)
+{
+    if (PolicyWarming::isWarming())
+    {
+        touchMeta();
+        ResolvePendingFill();
+        blockPrefetch()[accessed_index] = 0;
+        PromoteBlock(accessed_index);
+
+        if (m_lifetime)
+        {
+            g_lifetime.hit(m_lifetime, m_associativity, accessed_index);
+        }
+
+        return;
+    }
+
+    UInt64 tsc = PolicyTimer::start();
+
+    touchMeta();
+    ResolvePendingFill();
+
+    /* The hit counts of the phase signature are only read with phase_memo;
+     * without deferral they are kept anyway, as before */
+    if ((blockOwner()[accessed_index] < 2) && !IsTuneLeader()
+        && (!m_params->deferred_hits || m_params->phase_memo))
+    {
+        g_windowHits[blockOwner()[accessed_index]]++;
+    }
+
+    /* First hit to a prefetched block: the prefetch was useful, from now on
+     * the block is treated like a demand block */
+    if (blockPrefetch()[accessed_index])
     {
-        m_rrip_bits[accessed_index] = 0;
+        blockPrefetch()[accessed_index] = 0;
+        UpdatePrefetchInsertion(blockOwner()[accessed_index], true, m_params->prefetch_window,
+                                m_params->prefetch_accuracy_threshold, m_params->prefetch_bypass_threshold);
     }
+
+    if (m_lifetime)
+    {
+        g_lifetime.hit(m_lifetime, m_associativity, accessed_index);
+    }
+
+    if (m_params->sharer_aware)
+    {
+        core_id_t core_id = Sim()->getCoreManager()->getCurrentCoreID();
+
+        if (core_id >= 0)
+        {
+            bool was_shared = isShared(accessed_index);
+
+            if ((core_id < 2) && (core_id != blockOwner()[accessed_index]))
+            {
+                g_numCrossCoreHits[core_id]++;
+            }
+
+            blockSharers()[accessed_index] |= 1 << (core_id % 8);
+
+            if (!was_shared && isShared(accessed_index))
+            {
+                g_numSharedBlocks++;
+            }
+        }
+    }
+
+    /* Everything above is seen by other sets or needs the time of the hit,
+     * and stays on the hit path. The
+     * promotion is only read by the next miss of this set, which applies it
+     * in deferred mode */
+    if (m_params->deferred_hits)
+    {
+        m_touched |= UInt64(1) << accessed_index;
+    }
+    else
+    {
+        PromoteBlock(accessed_index);
+    }
+
+    g_hitTimer.stop(tsc, 0);
 }
 
 
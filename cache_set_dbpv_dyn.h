@@ -3,6 +3,10 @@
 
 #include "cache_set.h"
 #include "cache_set_lru.h"
+#include "cache_set_srrip_params.h"
+#include "cache_set_meta_arena.h"
+#include "cache_set_lockstep.h"
+#include "cache_set_lifetime.h"
 
 
 class CacheSetDBPV_DYN : public CacheSet
@@ -19,15 +23,57 @@ class CacheSetDBPV_DYN : public CacheSet
 
 
    private:
-      const UInt32 m_saturation_counter_max_value;
-      const UInt32 m_db_percent_threshold;
-      const UInt8  m_rrip_numbits;
-      const UInt8  m_rrip_max;
-      const UInt8  m_rrip_insert;
-            UInt8 *m_rrip_bits;
-            UInt8 *m_block_owner;
-            UInt8 *m_block_access; /* Number of times block got accessed */
+      UInt32 FindReplacementIndex(CacheCntlr *cntlr, core_id_t core_id, UInt32 &path);
+      UInt32 WarmReplacementIndex(core_id_t core_id);
+      UInt8  DemandInsertion(core_id_t core_id, bool pending);
+      UInt8  BimodalInsertion(core_id_t core_id, UInt8 insert);
+      void ResolvePendingFill();
+      void PromoteBlock(UInt32 index);
+      void ApplyDeferredHits();
+      void RecordDemandFill(UInt32 index, core_id_t core_id, bool evicted);
+      bool IsInclusionVictim(CacheCntlr *cntlr, UInt32 index, UInt32 &num_queries);
+
+      void AllocateMeta();
+
+      /* Leader set of the autotuner, runs the window of its group */
+      bool IsTuneLeader() const
+      {
+         return (0xff != m_tune_group);
+      }
+
+      void touchMeta()
+      {
+         if (NULL == m_meta)
+         {
+            AllocateMeta();
+         }
+      }
+
+      /* Per-way arrays, packed in one arena chunk: RRPV, owner core, number
+       * of times the block got accessed, block was filled by a prefetch and
+       * not yet hit, cores (modulo 8) that filled or hit the block */
+      enum { META_RRIP = 0, META_OWNER, META_ACCESS, META_PREFETCH, META_SHARERS, META_ARRAYS };
+
+      UInt8* rripBits()      const { return m_meta + META_RRIP     * m_associativity; }
+      UInt8* blockOwner()    const { return m_meta + META_OWNER    * m_associativity; }
+      UInt8* blockAccess()   const { return m_meta + META_ACCESS   * m_associativity; }
+      UInt8* blockPrefetch() const { return m_meta + META_PREFETCH * m_associativity; }
+      UInt8* blockSharers()  const { return m_meta + META_SHARERS  * m_associativity; }
+
+      bool isShared(UInt32 index) const
+      {
+         return 0 != (blockSharers()[index] & (blockSharers()[index] - 1));
+      }
+
+      const SRRIPParams *m_params;
+            UInt8 *m_meta;   /* NULL until the set is first touched */
+            UInt8 *m_lifetime;   /* Lifetime tracker chunk, NULL unless enabled */
+      RRIPReference *m_reference;   /* Lockstep checker, NULL unless enabled */
+            UInt8  m_tune_group;    /* Leader group of the autotuner, 0xff for followers */
             UInt8  m_replacement_pointer;
+            UInt32 m_pending_fill;  /* Way filled last, classified on next set access */
+            bool   m_pending_fill_evict;
+            UInt64 m_touched;   /* Ways hit since the last miss (srrip/deferred_hits) */
       CacheSetInfoLRU* m_set_info;
 };
 
@@ -0,0 +1,364 @@
+#include "cache_set_hawkeye.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+#include "cache.h"
+#include "stats.h"
+#include "cache_set_stat_counter.h"
+
+#include <cstring>
+
+#define RRPV_MAX            7
+#define PREDICTOR_MAX       7
+#define PREDICTOR_FRIENDLY  4   /* Counters at or above are cache-friendly */
+#define OPTGEN_WINDOW_WAYS  8   /* OPTgen looks back 8x associativity accesses */
+
+static UInt8  g_iteration_count = 0;
+static UInt32 g_sample_period;
+static UInt32 g_region_shift;
+static UInt32 g_predictor_bits;
+static UInt32 g_window;
+
+/* Signature-indexed 3-bit counters, shared by all sets */
+static UInt8 *g_predictor = NULL;
+
+static StatCounter g_numOptAccesses;
+static StatCounter g_numOptHits;
+static StatCounter g_numFriendlyInserts;
+static StatCounter g_numAverseInserts;
+static StatCounter g_numDetrains;
+static StatCounter g_numTouchedSets;
+
+static UInt16 Signature(IntPtr tag, core_id_t core_id)
+{
+    UInt64 key = ((UInt64)(tag >> g_region_shift) << 3) | (core_id & 7);
+
+    key ^= key >> 29;
+    key *= 0x9e3779b97f4a7c15ULL;
+
+    return (UInt16)(key >> (64 - g_predictor_bits));
+}
+
+static bool Predict(UInt16 signature)
+{
+    return g_predictor[signature] >= PREDICTOR_FRIENDLY;
+}
+
+static void Train(UInt16 signature, bool friendly)
+{
+    UInt8 &counter = g_predictor[signature];
+
+    if (friendly)
+    {
+        if (counter < PREDICTOR_MAX)
+            counter++;
+    }
+    else if (counter > 0)
+    {
+        counter--;
+    }
+}
+
+CacheSetHawkeye::CacheSetHawkeye(
+      String cfgname, core_id_t core_id,
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize, CacheSetInfoLRU* set_info, UInt8 num_attempts)
+   : CacheSet(cache_type, associativity, blocksize)
+   , m_kernel(getRRIPKernel(associativity, RRPV_MAX))
+   , m_meta(NULL)   /* Allocated on first touch of the set */
+   , m_sampler(NULL)
+   , m_replacement_pointer(0)
+   , m_pending_fill(associativity)
+   , m_pending_core(0)
+   , m_set_info(set_info)
+{
+    static UInt32 setID = 0;
+
+    if (0 == g_iteration_count)
+    {
+        g_iteration_count++;
+
+        config::Config *cfg = Sim()->getCfg();
+
+        g_sample_period  = cfg->getIntDefault(cfgname + "/srrip/hawkeye_sample_period", 64);
+        g_predictor_bits = cfg->getIntDefault(cfgname + "/srrip/hawkeye_predictor_bits", 12);
+        g_window         = OPTGEN_WINDOW_WAYS * associativity;
+
+        /* The tag holds the set index in its low bits, so a region of one
+         * tag would only ever train the set it maps to. By default a region
+         * spans every set: cache_size is in KB */
+        {
+            UInt64 num_sets = (UInt64)cfg->getInt(cfgname + "/cache_size") * 1024 / (associativity * blocksize);
+            UInt32 set_bits = 0;
+
+            while ((1ULL << set_bits) < num_sets)
+            {
+                set_bits++;
+            }
+
+            g_region_shift = cfg->getIntDefault(cfgname + "/srrip/hawkeye_region_shift", set_bits);
+        }
+
+        LOG_ASSERT_ERROR((g_predictor_bits > 0) && (g_predictor_bits <= 16), "srrip/hawkeye_predictor_bits must be 1..16");
+        LOG_ASSERT_ERROR(g_sample_period > 0, "srrip/hawkeye_sample_period must be non-zero");
+
+        /* Weakly friendly until trained */
+        g_predictor = new UInt8[1 << g_predictor_bits];
+        memset(g_predictor, PREDICTOR_FRIENDLY, 1 << g_predictor_bits);
+
+        printf("\n[Newton] Hawkeye with associativity:%d Sample Period:%u Predictor:2^%u Region Shift:%u OPTgen Window:%u Kernel:%s!!!\n",
+               associativity, g_sample_period, g_predictor_bits, g_region_shift, g_window, m_kernel->name);
+
+        g_numOptAccesses.registerMetric("interval_timer", core_id, "optgenAccesses");
+        g_numOptHits.registerMetric("interval_timer", core_id, "optgenHits");
+        g_numFriendlyInserts.registerMetric("interval_timer", core_id, "hawkeyeFriendlyInserts");
+        g_numAverseInserts.registerMetric("interval_timer", core_id, "hawkeyeAverseInserts");
+        g_numDetrains.registerMetric("interval_timer", core_id, "hawkeyeDetrains");
+        g_numTouchedSets.registerMetric("interval_timer", core_id, "hawkeyeTouchedSets");
+    }
+
+    if (0 == (setID % g_sample_period))
+    {
+        m_sampler = new Sampler;
+        m_sampler->occupancy = new UInt8[g_window]();
+        m_sampler->entries   = new SamplerEntry[g_window]();
+        m_sampler->time      = 0;
+    }
+
+    setID++;
+}
+
+CacheSetHawkeye::~CacheSetHawkeye()
+{
+   /* m_meta belongs to the arena */
+   if (m_sampler)
+   {
+      delete [] m_sampler->occupancy;
+      delete [] m_sampler->entries;
+      delete m_sampler;
+   }
+}
+
+void
+CacheSetHawkeye::AllocateMeta()
+{
+    m_meta = SetMetaArena::get(signatureOffset() + sizeof(UInt16) * m_associativity)->allocate();
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        rripBits()[i] = RRPV_MAX;
+    }
+
+    g_numTouchedSets++;
+}
+
+/* OPTgen. A reuse is an OPT hit if OPT had room to keep the block over the
+ * whole interval since its last access, i.e. fewer than associativity
+ * blocks are already kept across every access in between. The window is
+ * 8x associativity accesses of the set; older reuses count as OPT misses.
+ */
+void
+CacheSetHawkeye::SamplerAccess(IntPtr tag, UInt16 signature)
+{
+    Sampler &sampler = *m_sampler;
+    UInt32 now = sampler.time++;
+    SamplerEntry *entry = NULL;
+    SamplerEntry *oldest = &sampler.entries[0];
+
+    sampler.occupancy[now % g_window] = 0;
+
+    for (UInt32 i = 0; i < g_window; i++)
+    {
+        SamplerEntry &e = sampler.entries[i];
+
+        if (e.valid && (e.tag == tag))
+        {
+            entry = &e;
+            break;
+        }
+
+        if (oldest->valid && (!e.valid || (e.time < oldest->time)))
+        {
+            oldest = &e;
+        }
+    }
+
+    if (entry)
+    {
+        bool opt_hit = (now - entry->time) < g_window;
+
+        for (UInt32 t = entry->time; opt_hit && (t != now); t++)
+        {
+            if (sampler.occupancy[t % g_window] >= m_associativity)
+            {
+                opt_hit = false;
+            }
+        }
+
+        if (opt_hit)
+        {
+            for (UInt32 t = entry->time; t != now; t++)
+            {
+                sampler.occupancy[t % g_window]++;
+            }
+
+            g_numOptHits++;
+        }
+
+        Train(entry->signature, opt_hit);
+        g_numOptAccesses++;
+    }
+    else
+    {
+        /* The sampler holds as many entries as the window is long, so the
+         * oldest entry is out of the window once all are in use */
+        entry = oldest;
+    }
+
+    entry->valid     = true;
+    entry->tag       = tag;
+    entry->time      = now;
+    entry->signature = signature;
+}
+
+/* Friendly blocks enter at RRPV 0 and age the other friendly blocks, so
+ * that the oldest of them becomes the victim when no averse block is
+ * left. Averse blocks enter at RRPV 7, the next victim. */
+void
+CacheSetHawkeye::InsertBlock(UInt32 index, bool friendly)
+{
+    UInt8 *rrip_bits = rripBits();
+
+    if (friendly)
+    {
+        for (UInt32 i = 0; i < m_associativity; i++)
+        {
+            if (rrip_bits[i] < RRPV_MAX - 1)
+            {
+                rrip_bits[i]++;
+            }
+        }
+
+        rrip_bits[index] = 0;
+        g_numFriendlyInserts++;
+    }
+    else
+    {
+        rrip_bits[index] = RRPV_MAX;
+        g_numAverseInserts++;
+    }
+}
+
+void
+CacheSetHawkeye::ResolvePendingFill()
+{
+    UInt32 index = m_pending_fill;
+
+    if (index >= m_associativity)
+    {
+        return;
+    }
+
+    m_pending_fill = m_associativity;
+
+    if (!m_cache_block_info_array[index]->isValid())
+    {
+        return;
+    }
+
+    IntPtr tag = m_cache_block_info_array[index]->getTag();
+    UInt16 signature = Signature(tag, m_pending_core);
+
+    blockSignature()[index] = signature;
+    InsertBlock(index, Predict(signature));
+
+    if (m_sampler)
+    {
+        SamplerAccess(tag, signature);
+    }
+}
+
+UInt32
+CacheSetHawkeye::getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id)
+{
+    UInt8 *rrip_bits;
+    UInt32 index = m_associativity;
+
+    touchMeta();
+    ResolvePendingFill();
+    rrip_bits = rripBits();
+
+    for (UInt32 i = 0; i < m_associativity; i++)
+    {
+        if (!m_cache_block_info_array[i]->isValid())
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (index == m_associativity)
+    {
+        /* An averse block, first one at or after the replacement pointer */
+        UInt64 candidates = m_kernel->maxMask(rrip_bits, m_associativity, RRPV_MAX);
+
+        while (candidates)
+        {
+            UInt32 way = nextWayInMask(candidates, m_replacement_pointer);
+
+            if (isValidReplacement(way))
+            {
+                index = way;
+                break;
+            }
+
+            candidates &= ~(1ULL << way);
+        }
+    }
+
+    if (index == m_associativity)
+    {
+        /* Only friendly blocks are left: evict the oldest one, and detrain
+         * its signature since the prediction kept a block OPT would not */
+        UInt8 max_rrpv = 0;
+
+        for (UInt32 i = 0; i < m_associativity; i++)
+        {
+            if (isValidReplacement(i) && ((index == m_associativity) || (rrip_bits[i] > max_rrpv)))
+            {
+                index = i;
+                max_rrpv = rrip_bits[i];
+            }
+        }
+
+        LOG_ASSERT_ERROR(index < m_associativity, "Hawkeye found no valid replacement candidate");
+
+        Train(blockSignature()[index], false);
+        g_numDetrains++;
+    }
+
+    m_replacement_pointer = (index + 1) % m_associativity;
+
+    /* Predicted at the next access to the set, once the tag is in */
+    rrip_bits[index] = RRPV_MAX;
+    m_pending_fill = index;
+    m_pending_core = core_id;
+
+    return index;
+}
+
+void
+CacheSetHawkeye::updateReplacementIndex(UInt32 accessed_index)
+{
+    touchMeta();
+    ResolvePendingFill();
+
+    UInt16 signature = blockSignature()[accessed_index];
+
+    if (m_sampler)
+    {
+        SamplerAccess(m_cache_block_info_array[accessed_index]->getTag(), signature);
+    }
+
+    rripBits()[accessed_index] = Predict(signature) ? 0 : RRPV_MAX;
+}
@@ -0,0 +1,87 @@
+#ifndef CACHE_SET_HAWKEYE_H
+#define CACHE_SET_HAWKEYE_H
+
+#include "cache_set.h"
+#include "cache_set_lru.h"
+#include "cache_set_rrip_kernel.h"
+#include "cache_set_meta_arena.h"
+
+/* Hawkeye (Jain and Lin, ISCA 2016). A few sampled sets replay their
+ * accesses through OPTgen, which tells for every reuse whether Belady's OPT
+ * would have kept the block over the interval. The verdicts train a table
+ * of 3-bit counters indexed by the signature of the fill, and every set
+ * inserts blocks at RRPV 0 (cache-friendly) or RRPV 7 (cache-averse) by
+ * what the table predicts for them.
+ *
+ * The set is not given the PC of the access, so the signature hashes the
+ * filling core with the tag shifted right by srrip/hawkeye_region_shift,
+ * i.e. the memory region of the block. The shift defaults to the number of
+ * set index bits, so that a region spans all sets and trains them together.
+ * The tag of a filled block is only known after the fill, so a fill is
+ * predicted at the next access to the set, as DBPV_DYN classifies its
+ * prefetch fills.
+ */
+class CacheSetHawkeye : public CacheSet
+{
+   public:
+      CacheSetHawkeye(String cfgname, core_id_t core_id,
+            CacheBase::cache_t cache_type,
+            UInt32 associativity, UInt32 blocksize, CacheSetInfoLRU* set_info, UInt8 num_attempts);
+      ~CacheSetHawkeye();
+
+      UInt32 getReplacementIndex(CacheCntlr *cntlr, core_id_t core_id);
+      void updateReplacementIndex(UInt32 accessed_index);
+
+
+   private:
+      /* One block the sampler has seen in the last OPTgen window */
+      struct SamplerEntry
+      {
+         IntPtr tag;
+         UInt32 time;       /* Set access count at the last access */
+         UInt16 signature;
+         bool   valid;
+      };
+
+      /* OPTgen state of a sampled set. occupancy[t % window] is the number
+       * of blocks OPT keeps cached across access t of the set. */
+      struct Sampler
+      {
+         UInt8        *occupancy;
+         SamplerEntry *entries;
+         UInt32        time;
+      };
+
+      void ResolvePendingFill();
+      void InsertBlock(UInt32 index, bool friendly);
+      void SamplerAccess(IntPtr tag, UInt16 signature);
+
+      void AllocateMeta();
+
+      void touchMeta()
+      {
+         if (NULL == m_meta)
+         {
+            AllocateMeta();
+         }
+      }
+
+      /* Per-way arrays, packed in one arena chunk: RRPV and the signature
+       * of the fill (2 bytes per way, 2-byte aligned) */
+      enum { META_RRIP = 0, META_BYTE_ARRAYS };
+
+      UInt32  signatureOffset() const { return (META_BYTE_ARRAYS * m_associativity + 1) & ~1U; }
+
+      UInt8*  rripBits()       const { return m_meta + META_RRIP * m_associativity; }
+      UInt16* blockSignature() const { return (UInt16*)(m_meta + signatureOffset()); }
+
+      const RRIPKernel *m_kernel;
+            UInt8 *m_meta;      /* NULL until the set is first touched */
+            Sampler *m_sampler; /* NULL unless this is a sampled set */
+            UInt8  m_replacement_pointer;
+            UInt32 m_pending_fill;  /* Way filled last, predicted on next set access */
+            core_id_t m_pending_core;
+      CacheSetInfoLRU* m_set_info;
+};
+
+#endif /* CACHE_SET_HAWKEYE_H */
@@ -0,0 +1,74 @@
+#include "cache_set_lifetime.h"
+#include "cache_set_meta_arena.h"
+#include "utils.h"
+
+extern UInt64 g_cycles_count;
+extern UInt64 g_instruction_count;
+
+static UInt32 log2Bucket(UInt32 value)
+{
+   return value ? 32 - __builtin_clz(value) : 0;
+}
+
+LifetimeTracker::LifetimeTracker()
+   : m_clock(&g_cycles_count)
+   , m_epoch_shift(0)
+{
+}
+
+void
+LifetimeTracker::configure(UInt32 epoch_shift, bool instructions)
+{
+   m_clock       = instructions ? &g_instruction_count : &g_cycles_count;
+   m_epoch_shift = epoch_shift;
+}
+
+void
+LifetimeTracker::registerMetrics(UInt32 index)
+{
+   for (UInt32 c = 0; c < MAX_CORES; c++)
+   {
+      String core = String("-C") + itostr(c) + "-";
+
+      for (UInt32 b = 0; b < TIME_BUCKETS; b++)
+      {
+         m_live[c][b].registerMetric("interval_timer", index, String("lifetime-live") + core + itostr(b));
+         m_ttlh[c][b].registerMetric("interval_timer", index, String("lifetime-ttlh") + core + itostr(b));
+         m_dead[c][b].registerMetric("interval_timer", index, String("lifetime-dead") + core + itostr(b));
+      }
+
+      for (UInt32 b = 0; b < HIT_BUCKETS; b++)
+      {
+         m_hits[c][b].registerMetric("interval_timer", index, String("lifetime-hits") + core + itostr(b));
+      }
+   }
+}
+
+UInt8*
+LifetimeTracker::allocate(UInt32 associativity)
+{
+   return SetMetaArena::get(5 * associativity)->allocate();
+}
+
+void
+LifetimeTracker::evict(UInt8 *chunk, UInt32 associativity, UInt32 way, UInt32 owner)
+{
+   if (owner >= MAX_CORES)
+   {
+      return;
+   }
+
+   UInt16 evicted  = now();
+   UInt16 filled   = fillEpoch(chunk)[way];
+   UInt16 last_hit = lastHitEpoch(chunk, associativity)[way];
+   UInt8  count    = hits(chunk, associativity)[way];
+
+   m_live[owner][log2Bucket(UInt16(evicted - filled))]++;
+   m_dead[owner][log2Bucket(UInt16(evicted - last_hit))]++;
+   m_hits[owner][log2Bucket(count)]++;
+
+   if (count)
+   {
+      m_ttlh[owner][log2Bucket(UInt16(last_hit - filled))]++;
+   }
+}
@@ -0,0 +1,73 @@
+#ifndef CACHE_SET_LIFETIME_H
+#define CACHE_SET_LIFETIME_H
+
+#include "fixed_types.h"
+#include "cache_set_stat_counter.h"
+
+/* Block lifetime tracker (srrip/lifetime_stats).
+ *
+ * Every way of a tracked set keeps the epoch it was filled in, the epoch of
+ * its last hit and its hits in this generation. An epoch is the cycle (or
+ * instruction) counter shifted right by srrip/lifetime_epoch_shift, kept
+ * as 16 bits; times are differences modulo 2^16 epochs, so the shift must
+ * make typical lifetimes shorter than that.
+ *
+ * On eviction the generation feeds per-core log2 histograms:
+ *   live  fill to eviction
+ *   ttlh  fill to last hit, blocks with at least one hit
+ *   dead  last hit (or fill) to eviction
+ *   hits  hits of the generation
+ * Bucket 0 is a zero value, bucket b holds [2^(b-1), 2^b). The histograms
+ * are StatCounters, exported with the interval stats, so memory stays
+ * constant however long the run.
+ */
+class LifetimeTracker
+{
+   public:
+      LifetimeTracker();
+
+      void configure(UInt32 epoch_shift, bool instructions);
+      void registerMetrics(UInt32 index);
+
+      /* Per-set chunk of the tracker, zeroed */
+      UInt8* allocate(UInt32 associativity);
+
+      void fill(UInt8 *chunk, UInt32 associativity, UInt32 way) const
+      {
+         fillEpoch(chunk)[way]                   = now();
+         lastHitEpoch(chunk, associativity)[way] = fillEpoch(chunk)[way];
+         hits(chunk, associativity)[way]         = 0;
+      }
+
+      void hit(UInt8 *chunk, UInt32 associativity, UInt32 way) const
+      {
+         UInt8 &count = hits(chunk, associativity)[way];
+
+         lastHitEpoch(chunk, associativity)[way] = now();
+         count += (0xff != count);
+      }
+
+      void evict(UInt8 *chunk, UInt32 associativity, UInt32 way, UInt32 owner);
+
+      static const UInt32 MAX_CORES    = 2;
+      static const UInt32 TIME_BUCKETS = 17;
+      static const UInt32 HIT_BUCKETS  = 9;
+
+   private:
+      /* Chunk layout: fill epochs, last hit epochs, hit counts */
+      static UInt16* fillEpoch(UInt8 *chunk)                           { return (UInt16*)chunk; }
+      static UInt16* lastHitEpoch(UInt8 *chunk, UInt32 associativity)  { return (UInt16*)chunk + associativity; }
+      static UInt8*  hits(UInt8 *chunk, UInt32 associativity)          { return chunk + 4 * associativity; }
+
+      UInt16 now() const { return UInt16(*m_clock >> m_epoch_shift); }
+
+      const UInt64 *m_clock;
+            UInt32  m_epoch_shift;
+
+      StatCounter m_live[MAX_CORES][TIME_BUCKETS];
+      StatCounter m_ttlh[MAX_CORES][TIME_BUCKETS];
+      StatCounter m_dead[MAX_CORES][TIME_BUCKETS];
+      StatCounter m_hits[MAX_CORES][HIT_BUCKETS];
+};
+
+#endif /* CACHE_SET_LIFETIME_H */
@@ -0,0 +1,293 @@
+#include "cache_set_lockstep.h"
+#include "cache_set.h"
+#include "log.h"
+
+RRIPReference::RRIPReference(const char *policy, UInt32 associativity, UInt8 rrip_max, UInt8 rrip_insert)
+   : m_policy(policy)
+   , m_associativity(associativity)
+   , m_rrip_max(rrip_max)
+   , m_replacement_pointer(0)
+   , m_num_steps(0)
+{
+   m_rrip_bits = new UInt8[m_associativity];
+   for (UInt32 i = 0; i < m_associativity; i++)
+      m_rrip_bits[i] = rrip_insert;
+}
+
+RRIPReference::~RRIPReference()
+{
+   delete [] m_rrip_bits;
+}
+
+UInt32
+RRIPReference::getReplacementIndex(CacheCntlr *cntlr, CacheBlockInfo **blocks, UInt8 num_attempts)
+{
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if (!blocks[i]->isValid())
+      {
+         return i;
+      }
+   }
+
+   for (UInt32 j = 0; j <= m_rrip_max; ++j)
+   {
+      UInt32 first_candidate = m_associativity;
+      UInt32 num_queries = 0;
+
+      for (UInt32 i = 0; i < m_associativity; i++)
+      {
+         UInt32 way = (m_replacement_pointer + i) % m_associativity;
+
+         if (m_rrip_bits[way] < m_rrip_max)
+         {
+            continue;
+         }
+
+         if (m_associativity == first_candidate)
+         {
+            first_candidate = way;
+         }
+
+         /* Query based selection: candidates still held by a private
+          * cache are skipped while queries are left */
+         if ((NULL != cntlr) && (num_queries + 1 < num_attempts))
+         {
+            num_queries++;
+
+            if (cntlr->isInLowerLevelCache(blocks[way]))
+            {
+               continue;
+            }
+         }
+
+         m_replacement_pointer = (way + 1) % m_associativity;
+         return way;
+      }
+
+      if (first_candidate < m_associativity)
+      {
+         m_replacement_pointer = (first_candidate + 1) % m_associativity;
+         return first_candidate;
+      }
+
+      // Increment all RRIP counters until one hits RRIP_MAX
+      for (UInt32 i = 0; i < m_associativity; i++)
+      {
+         if (m_rrip_bits[i] < m_rrip_max)
+         {
+            m_rrip_bits[i]++;
+         }
+      }
+   }
+
+   LOG_PRINT_ERROR("[Newton] Lockstep: reference %s found no victim", m_policy);
+}
+
+void
+RRIPReference::check(const char *op, UInt32 expected_way, UInt32 actual_way,
+                     const UInt8 *rrip_bits, UInt32 replacement_pointer)
+{
+   bool diverged = (expected_way != actual_way) || (m_replacement_pointer != replacement_pointer);
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      diverged |= (m_rrip_bits[i] != rrip_bits[i]);
+   }
+
+   m_num_steps++;
+
+   if (!diverged)
+   {
+      return;
+   }
+
+   printf("\n[Newton] Lockstep divergence in %s, %s, step %lu\n", m_policy, op, m_num_steps);
+   printf("[Newton]   way       reference:%u checked:%u\n", expected_way, actual_way);
+   printf("[Newton]   pointer   reference:%u checked:%u\n", m_replacement_pointer, replacement_pointer);
+   printf("[Newton]   way   ref  chk\n");
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      printf("[Newton]   %3u  %4u %4u%s\n", i, m_rrip_bits[i], rrip_bits[i],
+             (m_rrip_bits[i] != rrip_bits[i]) ? "  <--" : "");
+   }
+
+   LOG_PRINT_ERROR("[Newton] Lockstep check failed for %s", m_policy);
+}
+
+RecencyReference::RecencyReference(UInt32 associativity, UInt8 owner_none)
+   : m_associativity(associativity)
+   , m_num_steps(0)
+{
+   m_position = new UInt8[m_associativity];
+   m_owner = new UInt8[m_associativity];
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      m_position[i] = i;
+      m_owner[i] = owner_none;
+   }
+}
+
+RecencyReference::~RecencyReference()
+{
+   delete [] m_position;
+   delete [] m_owner;
+}
+
+UInt32
+RecencyReference::getWay(UInt32 position) const
+{
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if (m_position[i] == position)
+      {
+         return i;
+      }
+   }
+
+   return m_associativity;
+}
+
+UInt32
+RecencyReference::getLRUWay(UInt8 owner) const
+{
+   UInt32 way = m_associativity;
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if ((m_owner[i] == owner) && ((m_associativity == way) || (m_position[i] > m_position[way])))
+      {
+         way = i;
+      }
+   }
+
+   return way;
+}
+
+UInt32
+RecencyReference::getLRUWayInMask(UInt64 mask) const
+{
+   UInt32 way = m_associativity;
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if (((mask >> i) & 1) && ((m_associativity == way) || (m_position[i] > m_position[way])))
+      {
+         way = i;
+      }
+   }
+
+   return way;
+}
+
+/* The original per-owner scan: count the ways of every core, the core
+ * furthest over its quota gives up its LRU way. Otherwise the requester
+ * gives up its own LRU way, or the LRU way of the set if it holds none. */
+UInt32
+RecencyReference::getPartitionVictim(UInt32 core_id, const UInt8 *quota, UInt32 num_cores) const
+{
+   UInt32 count[256] = { 0 };
+   UInt32 victim_core = num_cores;
+   SInt32 max_excess  = 0;
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if (m_owner[i] < num_cores)
+      {
+         count[m_owner[i]]++;
+      }
+   }
+
+   for (UInt32 c = 0; c < num_cores; c++)
+   {
+      SInt32 excess = (SInt32)count[c] - (SInt32)quota[c];
+
+      if (excess > max_excess)
+      {
+         max_excess  = excess;
+         victim_core = c;
+      }
+   }
+
+   if (victim_core < num_cores)
+   {
+      return getLRUWay(victim_core);
+   }
+
+   if (count[core_id] > 0)
+   {
+      return getLRUWay(core_id);
+   }
+
+   return getWay(m_associativity - 1);
+}
+
+/* First invalid way in the mask, otherwise the LRU way in the mask */
+UInt32
+RecencyReference::getWayMaskVictim(UInt64 mask, UInt64 invalid) const
+{
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if ((mask >> i) & (invalid >> i) & 1)
+      {
+         return i;
+      }
+   }
+
+   return getLRUWayInMask(mask);
+}
+
+void
+RecencyReference::moveTo(UInt32 way, UInt32 position)
+{
+   UInt32 from = m_position[way];
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if ((position < from) && (m_position[i] >= position) && (m_position[i] < from))
+      {
+         m_position[i]++;
+      }
+      else if ((position > from) && (m_position[i] > from) && (m_position[i] <= position))
+      {
+         m_position[i]--;
+      }
+   }
+
+   m_position[way] = position;
+}
+
+void
+RecencyReference::check(const char *op, UInt32 expected, UInt32 actual,
+                        const UInt8 *stack, const UInt8 *owner)
+{
+   bool diverged = (expected != actual);
+
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      diverged |= (stack[m_position[i]] != i) || (owner[m_position[i]] != m_owner[i]);
+   }
+
+   m_num_steps++;
+
+   if (!diverged)
+   {
+      return;
+   }
+
+   printf("\n[Newton] Lockstep divergence in recency stack, %s, step %lu\n", op, m_num_steps);
+   printf("[Newton]   result    reference:%u checked:%u\n", expected, actual);
+   printf("[Newton]   pos   ref way/owner  chk way/owner\n");
+
+   for (UInt32 p = 0; p < m_associativity; p++)
+   {
+      UInt32 way = getWay(p);
+
+      printf("[Newton]   %3u   %3u/%-3u        %3u/%-3u%s\n", p, way, m_owner[way], stack[p], owner[p],
+             ((stack[p] != way) || (owner[p] != m_owner[way])) ? "  <--" : "");
+   }
+
+   LOG_PRINT_ERROR("[Newton] Lockstep check failed for the recency stack");
+}
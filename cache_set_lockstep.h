@@ -0,0 +1,89 @@
+#ifndef CACHE_SET_LOCKSTEP_H
+#define CACHE_SET_LOCKSTEP_H
+
+#include "fixed_types.h"
+
+class CacheCntlr;
+class CacheBlockInfo;
+
+/* Lockstep checker (srrip/lockstep_check = true).
+ *
+ * The fast paths of the policies (RRIP kernels, packed recency stack,
+ * lazily allocated metadata, ...) must evict exactly the same ways as the
+ * straightforward code the DAAIP results were produced with. In checker
+ * mode every set also drives a reference model, written the plain way,
+ * with the same inputs: same fills, hits and insertion values. After every
+ * operation the victim and the complete replacement state of both are
+ * compared. The first divergence dumps both states and stops the
+ * simulation, so the offending access can be replayed from the same run.
+ *
+ * The reference models are slow on purpose. Nothing is shared with the
+ * code they check, except the inputs.
+ */
+
+/* SRRIP victim search as in the original loop: sweep from the replacement
+ * pointer for a way at rrip_max; if there is none, age every way by one
+ * and sweep again. Query based selection skips up to num_attempts - 1
+ * candidates that are present in a private cache. */
+class RRIPReference
+{
+   public:
+      RRIPReference(const char *policy, UInt32 associativity, UInt8 rrip_max, UInt8 rrip_insert);
+      ~RRIPReference();
+
+      UInt32 getReplacementIndex(CacheCntlr *cntlr, CacheBlockInfo **blocks, UInt8 num_attempts);
+
+      /* Policy decisions, taken over from the checked set */
+      void setRRPV(UInt32 way, UInt8 rrpv) { m_rrip_bits[way] = rrpv; }
+      void setPointer(UInt32 pointer)      { m_replacement_pointer = pointer; }
+
+      /* SRRIP-HP promotion on a hit */
+      void hit(UInt32 way) { m_rrip_bits[way] = 0; }
+
+      /* Compare against the state of the checked set after operation op */
+      void check(const char *op, UInt32 expected_way, UInt32 actual_way,
+                 const UInt8 *rrip_bits, UInt32 replacement_pointer);
+
+   private:
+      const char  *m_policy;
+      const UInt32 m_associativity;
+      const UInt8  m_rrip_max;
+            UInt8 *m_rrip_bits;
+            UInt32 m_replacement_pointer;
+            UInt64 m_num_steps;
+};
+
+/* True-LRU recency stack kept as one position per way, the representation
+ * DBASP used before the packed stack: moving a way shifts every way in
+ * between by one position. */
+class RecencyReference
+{
+   public:
+      RecencyReference(UInt32 associativity, UInt8 owner_none);
+      ~RecencyReference();
+
+      UInt32 getPosition(UInt32 way) const { return m_position[way]; }
+      UInt32 getWay(UInt32 position) const;
+      UInt32 getLRUWay(UInt8 owner) const;
+      UInt32 getLRUWayInMask(UInt64 mask) const;
+
+      /* DBASP victims recounted from the owners of this stack: quota mode,
+       * and way-mask mode with the invalid ways of the set */
+      UInt32 getPartitionVictim(UInt32 core_id, const UInt8 *quota, UInt32 num_cores) const;
+      UInt32 getWayMaskVictim(UInt64 mask, UInt64 invalid) const;
+
+      void setOwner(UInt32 way, UInt8 owner) { m_owner[way] = owner; }
+      void moveTo(UInt32 way, UInt32 position);
+
+      /* stack and owner are the checked stack: way and owner per position */
+      void check(const char *op, UInt32 expected, UInt32 actual,
+                 const UInt8 *stack, const UInt8 *owner);
+
+   private:
+      const UInt32 m_associativity;
+            UInt8 *m_position;
+            UInt8 *m_owner;
+            UInt64 m_num_steps;
+};
+
+#endif /* CACHE_SET_LOCKSTEP_H */
@@ -0,0 +1,67 @@
+#include "cache_set_meta_arena.h"
+#include "log.h"
+#include "lock.h"
+
+#include <cstring>
+
+static std::vector<SetMetaArena*> g_meta_arenas;
+
+/* Sets are first touched on the access path, and accesses to a shared
+ * cache come from several simulation threads at once. The lock is only
+ * taken when a set is first touched, so one serves all arenas. */
+static Lock g_meta_arenas_lock;
+
+SetMetaArena::SetMetaArena(UInt32 chunk_size)
+   /* Keep every chunk 8-byte aligned for word-wide scans of the arrays */
+   : m_chunk_size((chunk_size + 7) & ~7)
+   , m_next(NULL)
+   , m_free_in_slab(0)
+   , m_num_chunks(0)
+{
+   LOG_ASSERT_ERROR(m_chunk_size > 0 && m_chunk_size <= SLAB_SIZE,
+                    "Set metadata chunk of %u bytes does not fit a slab", chunk_size);
+}
+
+SetMetaArena*
+SetMetaArena::get(UInt32 chunk_size)
+{
+   ScopedLock sl(g_meta_arenas_lock);
+
+   for (UInt32 i = 0; i < g_meta_arenas.size(); i++)
+   {
+      if (g_meta_arenas[i]->m_chunk_size == ((chunk_size + 7) & ~7))
+      {
+         return g_meta_arenas[i];
+      }
+   }
+
+   SetMetaArena *arena = new SetMetaArena(chunk_size);
+   g_meta_arenas.push_back(arena);
+
+   return arena;
+}
+
+UInt8*
+SetMetaArena::allocate()
+{
+   ScopedLock sl(g_meta_arenas_lock);
+
+   if (0 == m_free_in_slab)
+   {
+      /* Not cleared here: a large allocation comes straight from the OS
+       * and its pages are only backed once a chunk in them is used */
+      m_next = new UInt8[SLAB_SIZE];
+      m_free_in_slab = SLAB_SIZE / m_chunk_size;
+      m_slabs.push_back(m_next);
+   }
+
+   UInt8 *chunk = m_next;
+
+   m_next += m_chunk_size;
+   m_free_in_slab--;
+   m_num_chunks++;
+
+   memset(chunk, 0, m_chunk_size);
+
+   return chunk;
+}
@@ -0,0 +1,44 @@
+#ifndef CACHE_SET_META_ARENA_H
+#define CACHE_SET_META_ARENA_H
+
+#include "fixed_types.h"
+
+#include <vector>
+
+/* Pool for the per-set replacement metadata of large caches. A set asks
+ * for its chunk the first time it is touched, so a set the workload never
+ * reaches costs a NULL pointer only, and the policy state of a 256 MB LLC
+ * scales with the touched footprint instead of the nominal capacity.
+ *
+ * Chunks are carved from slabs of SLAB_SIZE bytes. A slab is only written
+ * where chunks are handed out, so the untouched tail of the last slab is
+ * never backed by memory either. Chunks live as long as the simulation.
+ * get() and allocate() may be called from several threads at once.
+ */
+class SetMetaArena
+{
+   public:
+      /* Arena for chunks of chunk_size bytes, shared by all caches that
+       * ask for the same size */
+      static SetMetaArena* get(UInt32 chunk_size);
+
+      /* Zeroed chunk of getChunkSize() bytes */
+      UInt8* allocate();
+
+      UInt32 getChunkSize() const { return m_chunk_size; }
+      UInt64 getNumChunks() const { return m_num_chunks; }
+      UInt64 getBytesReserved() const { return (UInt64)m_slabs.size() * SLAB_SIZE; }
+
+      static const UInt32 SLAB_SIZE = 1 << 20;
+
+   private:
+      SetMetaArena(UInt32 chunk_size);
+
+      const UInt32 m_chunk_size;
+            UInt8 *m_next;          /* Next free chunk in the current slab */
+            UInt32 m_free_in_slab;  /* Chunks left in the current slab */
+            UInt64 m_num_chunks;
+      std::vector<UInt8*> m_slabs;
+};
+
+#endif /* CACHE_SET_META_ARENA_H */
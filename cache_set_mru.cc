@@ -0,0 +1,73 @@
+#include "cache_set_mru.h"
+#include "log.h"
+
+// Implements Most Recently Used
+
+CacheSetMRU::CacheSetMRU(
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize) :
+   CacheSet(cache_type, associativity, blocksize),
+   m_used(0),
+   m_all_ways(allWaysMask(associativity)),
+   m_mru_way(0)
+{
+}
+
+CacheSetMRU::~CacheSetMRU()
+{}
+
+UInt32
+CacheSetMRU::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
+{
+   // First try to find an invalid block
+   UInt64 invalid = invalidWaysMask(m_cache_block_info_array, m_associativity);
+   UInt32 index;
+
+   if (invalid)
+   {
+      index = __builtin_ctzll(invalid);
+   }
+   else if (isValidReplacement(m_mru_way))
+   {
+      index = m_mru_way;
+   }
+   else
+   {
+      /* The MRU way is not replaceable right now: fall back to the other
+       * ways referenced since the last reset, then to the rest */
+      UInt64 candidates = m_used & ~(UInt64(1) << m_mru_way);
+      UInt64 others     = m_all_ways & ~m_used & ~(UInt64(1) << m_mru_way);
+
+      for (index = m_associativity; m_associativity == index; )
+      {
+         if (0 == candidates)
+         {
+            LOG_ASSERT_ERROR(0 != others, "Error finding replacement index");
+            candidates = others;
+            others     = 0;
+         }
+
+         UInt32 way = prevWayInMask(candidates, m_mru_way);
+
+         candidates &= ~(UInt64(1) << way);
+
+         if (isValidReplacement(way))
+            index = way;
+      }
+   }
+
+   updateReplacementIndex(index);
+   return index;
+}
+
+void
+CacheSetMRU::updateReplacementIndex(UInt32 accessed_index)
+{
+   m_mru_way = accessed_index;
+   m_used   |= UInt64(1) << accessed_index;
+
+   if (m_used == m_all_ways)
+   {
+      m_used = UInt64(1) << accessed_index;
+   }
+}
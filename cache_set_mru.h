@@ -2,6 +2,7 @@
 #define CACHE_SET_MRU_H
 
 #include "cache_set.h"
+#include "cache_set_way_mask.h"
 
 class CacheSetMRU : public CacheSet
 {
@@ -14,7 +15,9 @@ class CacheSetMRU : public CacheSet
       void updateReplacementIndex(UInt32 accessed_index);
 
    private:
-      UInt8* m_lru_bits;
+      UInt64 m_used;   /* Ways referenced since the last reset */
+      UInt64 m_all_ways;
+      UInt8  m_mru_way;
 };
 
 #endif /* CACHE_SET_MRU_H */
@@ -0,0 +1,60 @@
+#include "cache_set_nmru.h"
+#include "log.h"
+
+// Implements Not Most Recently Used: round-robin over all ways but the MRU one
+
+CacheSetNMRU::CacheSetNMRU(
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize) :
+   CacheSet(cache_type, associativity, blocksize),
+   m_not_mru(allWaysMask(associativity)),
+   m_all_ways(allWaysMask(associativity)),
+   m_replacement_pointer(0)
+{
+}
+
+CacheSetNMRU::~CacheSetNMRU()
+{}
+
+UInt32
+CacheSetNMRU::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
+{
+   // First try to find an invalid block
+   UInt64 invalid = invalidWaysMask(m_cache_block_info_array, m_associativity);
+
+   if (invalid)
+   {
+      UInt32 index = __builtin_ctzll(invalid);
+
+      // Mark our newly-inserted line as recently used
+      updateReplacementIndex(index);
+      return index;
+   }
+
+   /* A direct-mapped set has no way but the MRU one */
+   UInt64 candidates = m_not_mru ? m_not_mru : m_all_ways;
+
+   while (candidates)
+   {
+      UInt32 index = nextWayInMask(candidates, m_replacement_pointer);
+
+      if (isValidReplacement(index))
+      {
+         m_replacement_pointer = (index + 1) % m_associativity;
+
+         // Mark our newly-inserted line as recently used
+         updateReplacementIndex(index);
+         return index;
+      }
+
+      candidates &= ~(UInt64(1) << index);
+   }
+
+   LOG_PRINT_ERROR("Error finding replacement index");
+}
+
+void
+CacheSetNMRU::updateReplacementIndex(UInt32 accessed_index)
+{
+   m_not_mru = m_all_ways & ~(UInt64(1) << accessed_index);
+}
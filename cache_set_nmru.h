@@ -2,6 +2,7 @@
 #define CACHE_SET_NMRU_H
 
 #include "cache_set.h"
+#include "cache_set_way_mask.h"
 
 class CacheSetNMRU : public CacheSet
 {
@@ -14,7 +15,8 @@ class CacheSetNMRU : public CacheSet
       void updateReplacementIndex(UInt32 accessed_index);
 
    private:
-      UInt8* m_lru_bits;
+      UInt64 m_not_mru;   /* Every way but the most recently used one */
+      UInt64 m_all_ways;
       UInt8  m_replacement_pointer;
 };
 
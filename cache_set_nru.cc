@@ -0,0 +1,68 @@
+#include "cache_set_nru.h"
+#include "log.h"
+
+// Implements Not Recently Used, one referenced bit per way in a word
+
+CacheSetNRU::CacheSetNRU(
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize) :
+   CacheSet(cache_type, associativity, blocksize),
+   m_used(0),
+   m_all_ways(allWaysMask(associativity)),
+   m_replacement_pointer(0)
+{
+}
+
+CacheSetNRU::~CacheSetNRU()
+{}
+
+UInt32
+CacheSetNRU::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
+{
+   // First try to find an invalid block
+   UInt64 invalid = invalidWaysMask(m_cache_block_info_array, m_associativity);
+
+   if (invalid)
+   {
+      UInt32 index = __builtin_ctzll(invalid);
+
+      // Mark our newly-inserted line as recently used
+      updateReplacementIndex(index);
+      return index;
+   }
+
+   /* Victim is the first not recently used way from the replacement pointer
+    * on. Ways the controller cannot replace right now are dropped from the
+    * candidates one by one, which almost never happens. */
+   UInt64 candidates = ~m_used & m_all_ways;
+
+   while (candidates)
+   {
+      UInt32 index = nextWayInMask(candidates, m_replacement_pointer);
+
+      if (isValidReplacement(index))
+      {
+         m_replacement_pointer = (index + 1) % m_associativity;
+
+         // Mark our newly-inserted line as recently used
+         updateReplacementIndex(index);
+         return index;
+      }
+
+      candidates &= ~(UInt64(1) << index);
+   }
+
+   LOG_PRINT_ERROR("Error finding replacement index");
+}
+
+void
+CacheSetNRU::updateReplacementIndex(UInt32 accessed_index)
+{
+   m_used |= UInt64(1) << accessed_index;
+
+   /* All ways referenced: start a new period with only this one */
+   if (m_used == m_all_ways)
+   {
+      m_used = UInt64(1) << accessed_index;
+   }
+}
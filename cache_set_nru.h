@@ -2,6 +2,7 @@
 #define CACHE_SET_NRU_H
 
 #include "cache_set.h"
+#include "cache_set_way_mask.h"
 
 class CacheSetNRU : public CacheSet
 {
@@ -14,8 +15,8 @@ class CacheSetNRU : public CacheSet
       void updateReplacementIndex(UInt32 accessed_index);
 
    private:
-      UInt8* m_lru_bits;
-      UInt8  m_num_bits_set;
+      UInt64 m_used;   /* One bit per way, set when the way is referenced */
+      UInt64 m_all_ways;
       UInt8  m_replacement_pointer;
 };
 
@@ -0,0 +1,115 @@
+#include "cache_set_plru.h"
+#include "log.h"
+
+// Implements Tree Pseudo LRU
+
+static UInt64 g_path_mask[7][64];
+static UInt64 g_path_bits[7][64];
+static bool   g_path_init[7];
+
+/* An access to a way sets every node on its path to point to the sibling
+ * subtree; precomputed so the update is a single mask and or */
+static void initPaths(UInt32 levels)
+{
+   UInt32 associativity = 1 << levels;
+
+   for (UInt32 way = 0; way < associativity; way++)
+   {
+      UInt32 leaf = associativity + way;
+
+      g_path_mask[levels][way] = 0;
+      g_path_bits[levels][way] = 0;
+
+      for (UInt32 level = 0; level < levels; level++)
+      {
+         UInt32 node      = leaf >> (levels - level);
+         UInt32 went_right = (leaf >> (levels - level - 1)) & 1;
+
+         g_path_mask[levels][way] |= UInt64(1) << node;
+         g_path_bits[levels][way] |= UInt64(!went_right) << node;
+      }
+   }
+
+   g_path_init[levels] = true;
+}
+
+CacheSetPLRU::CacheSetPLRU(
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize) :
+   CacheSet(cache_type, associativity, blocksize),
+   m_tree(0),
+   m_levels(0)
+{
+   LOG_ASSERT_ERROR((associativity <= 64) && (0 == (associativity & (associativity - 1))),
+                    "PLRU not supported for associativity %d", associativity);
+
+   while ((UInt32(1) << m_levels) < associativity)
+   {
+      m_levels++;
+   }
+
+   /* Sets are created before the simulation runs, one after the other */
+   if (!g_path_init[m_levels])
+   {
+      initPaths(m_levels);
+   }
+
+   m_path_mask = g_path_mask[m_levels];
+   m_path_bits = g_path_bits[m_levels];
+}
+
+CacheSetPLRU::~CacheSetPLRU()
+{}
+
+/* Walk from the root following the node bits, one step per level. A subtree
+ * without a replaceable way is never entered: the direction is flipped when
+ * the chosen child covers no replaceable way. */
+UInt32
+CacheSetPLRU::getVictim(UInt64 replaceable) const
+{
+   UInt32 node = 1;
+
+   for (UInt32 level = 0; level < m_levels; level++)
+   {
+      UInt32 span  = m_levels - level - 1;   /* Child subtrees cover 2^span ways */
+      UInt32 right = (m_tree >> node) & 1;
+      UInt32 child = 2 * node + right;
+      UInt64 ways  = (replaceable >> ((child << span) - (UInt32(1) << m_levels))) & ((UInt64(1) << (1 << span)) - 1);
+
+      node = child ^ (0 == ways);
+   }
+
+   return node - (1 << m_levels);
+}
+
+UInt32
+CacheSetPLRU::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
+{
+   UInt64 replaceable = 0;
+
+   // Invalidations may mess up the LRU bits
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if (!m_cache_block_info_array[i]->isValid())
+      {
+         updateReplacementIndex(i);
+         return i;
+      }
+
+      replaceable |= UInt64(isValidReplacement(i)) << i;
+   }
+
+   LOG_ASSERT_ERROR(0 != replaceable, "PLRU found no replaceable way");
+
+   UInt32 index = getVictim(replaceable);
+
+   LOG_ASSERT_ERROR(isValidReplacement(index), "PLRU selected an invalid replacement candidate" );
+   updateReplacementIndex(index);
+   return index;
+}
+
+void
+CacheSetPLRU::updateReplacementIndex(UInt32 accessed_index)
+{
+   m_tree = (m_tree & ~m_path_mask[accessed_index]) | m_path_bits[accessed_index];
+}
@@ -3,6 +3,13 @@
 
 #include "cache_set.h"
 
+/* Tree pseudo-LRU for any power of two associativity up to 64.
+ *
+ * The associativity - 1 tree nodes are bits 1 .. associativity - 1 of one
+ * word, in heap order: node n has children 2n and 2n + 1, the leaves
+ * associativity .. 2 * associativity - 1 are the ways. A node bit of 0 points
+ * to the left subtree, 1 to the right one, towards the pseudo-LRU way.
+ */
 class CacheSetPLRU : public CacheSet
 {
    public:
@@ -14,7 +21,15 @@ class CacheSetPLRU : public CacheSet
       void updateReplacementIndex(UInt32 accessed_index);
 
    private:
-      UInt8 b[8];
+      UInt32 getVictim(UInt64 replaceable) const;
+
+      UInt64 m_tree;
+      UInt32 m_levels;   /* log2(associativity) */
+
+      /* Per way, the nodes on its path and the values pointing away from it,
+       * shared by all sets of the same associativity */
+      const UInt64 *m_path_mask;
+      const UInt64 *m_path_bits;
 };
 
 #endif /* CACHE_SET_PLRU_H */
@@ -0,0 +1,264 @@
+#ifndef CACHE_SET_RECENCY_STACK_H
+#define CACHE_SET_RECENCY_STACK_H
+
+#include "fixed_types.h"
+#include "log.h"
+#include "cache_set_lockstep.h"
+
+#include <cstring>
+
+/* True-LRU recency stack of one set, stored by position: m_stack[0] is the
+ * way at MRU, m_stack[assoc - 1] the way at LRU. m_owner keeps the owner of
+ * the way at each position, so the LRU block of one core is the deepest
+ * matching byte.
+ *
+ * Both arrays are packed bytes, padded to whole 64-bit words. Finding a way
+ * or an owner is a SWAR byte compare (two words for a 16-way set), finding
+ * the deepest way of a way mask a SWAR byte range compare. Moving a
+ * way in the stack is a single memmove. Positions are exact, so UCP reads
+ * the real stack distance of every hit.
+ *
+ * With enableLockstep(), every operation is repeated on a RecencyReference
+ * and the results and the whole stack are compared.
+ */
+class RecencyStack
+{
+   public:
+      RecencyStack(UInt32 associativity)
+         : m_associativity(associativity)
+         , m_num_words((associativity + 7) / 8)
+         , m_reference(NULL)
+      {
+         LOG_ASSERT_ERROR(associativity <= 255, "RecencyStack supports up to 255 ways");
+
+         m_stack = new UInt8[8 * m_num_words];
+         m_owner = new UInt8[8 * m_num_words];
+
+         /* Padding never matches a way or an owner */
+         memset(m_stack, 0xff, 8 * m_num_words);
+         memset(m_owner, OWNER_NONE, 8 * m_num_words);
+
+         for (UInt32 i = 0; i < m_associativity; i++)
+         {
+            m_stack[i] = i;
+         }
+      }
+
+      ~RecencyStack()
+      {
+         delete [] m_stack;
+         delete [] m_owner;
+         delete m_reference;
+      }
+
+      void enableLockstep()
+      {
+         m_reference = new RecencyReference(m_associativity, OWNER_NONE);
+      }
+
+      /* Stack distance of a way, 0 is MRU */
+      UInt32 getPosition(UInt32 way) const
+      {
+         UInt32 position = findPosition(way);
+
+         if (m_reference)
+         {
+            m_reference->check("getPosition", m_reference->getPosition(way), position, m_stack, m_owner);
+         }
+
+         return position;
+      }
+
+      UInt32 getWay(UInt32 position) const
+      {
+         if (m_reference)
+         {
+            m_reference->check("getWay", m_reference->getWay(position), m_stack[position], m_stack, m_owner);
+         }
+
+         return m_stack[position];
+      }
+
+      /* Way of the least recently used block owned by owner, or the
+       * associativity if owner has no block in the set */
+      UInt32 getLRUWay(UInt8 owner) const
+      {
+         UInt32 way = m_associativity;
+
+         for (UInt32 w = m_num_words; w-- > 0; )
+         {
+            UInt64 match = matchBytes(m_owner, w, owner);
+
+            if (match)
+            {
+               way = m_stack[8 * w + ((63 - __builtin_clzll(match)) >> 3)];
+               break;
+            }
+         }
+
+         if (m_reference)
+         {
+            m_reference->check("getLRUWay", m_reference->getLRUWay(owner), way, m_stack, m_owner);
+         }
+
+         return way;
+      }
+
+      /* Least recently used way among the ways set in mask; mask must
+       * contain at least one way of the set */
+      UInt32 getLRUWayInMask(UInt64 mask) const
+      {
+         UInt32 position = m_associativity;
+
+         for (UInt32 w = m_num_words; w-- > 0; )
+         {
+            UInt64 match = 0;
+
+            /* One byte range compare per run of contiguous ways in mask;
+             * CAT-style masks are a single run */
+            for (UInt64 runs = mask; runs; )
+            {
+               UInt32 lo   = __builtin_ctzll(runs);
+               UInt64 rest = ~(runs >> lo);
+               UInt32 end  = lo + (rest ? __builtin_ctzll(rest) : 64 - lo);
+
+               match |= matchRange(m_stack, w, lo, end);
+               runs   = (end < 64) ? (runs & (~UInt64(0) << end)) : 0;
+            }
+
+            if (match)
+            {
+               position = 8 * w + ((63 - __builtin_clzll(match)) >> 3);
+               break;
+            }
+         }
+
+         LOG_ASSERT_ERROR(position < m_associativity, "No way of mask %#lx in the set", mask);
+
+         if (m_reference)
+         {
+            m_reference->check("getLRUWayInMask", m_reference->getLRUWayInMask(mask), m_stack[position], m_stack, m_owner);
+         }
+
+         return m_stack[position];
+      }
+
+      /* Lockstep: compare the victim a DBASP set picked, from its own way
+       * counts, with the reference recounting the owners of its stack */
+      void checkPartitionVictim(UInt32 core_id, const UInt8 *quota, UInt32 num_cores, UInt32 victim) const
+      {
+         if (m_reference)
+         {
+            m_reference->check("getPartitionVictim", m_reference->getPartitionVictim(core_id, quota, num_cores),
+                               victim, m_stack, m_owner);
+         }
+      }
+
+      void checkWayMaskVictim(UInt64 mask, UInt64 invalid, UInt32 victim) const
+      {
+         if (m_reference)
+         {
+            m_reference->check("getWayMaskVictim", m_reference->getWayMaskVictim(mask, invalid),
+                               victim, m_stack, m_owner);
+         }
+      }
+
+      void setOwner(UInt32 way, UInt8 owner)
+      {
+         m_owner[findPosition(way)] = owner;
+
+         if (m_reference)
+         {
+            m_reference->setOwner(way, owner);
+            m_reference->check("setOwner", way, way, m_stack, m_owner);
+         }
+      }
+
+      /* Move way to stack position, shifting the ways in between by one */
+      void moveTo(UInt32 way, UInt32 position)
+      {
+         UInt32 from  = findPosition(way);
+         UInt8  owner = m_owner[from];
+
+         if (position < from)
+         {
+            memmove(&m_stack[position + 1], &m_stack[position], from - position);
+            memmove(&m_owner[position + 1], &m_owner[position], from - position);
+         }
+         else if (position > from)
+         {
+            memmove(&m_stack[from], &m_stack[from + 1], position - from);
+            memmove(&m_owner[from], &m_owner[from + 1], position - from);
+         }
+
+         m_stack[position] = way;
+         m_owner[position] = owner;
+
+         if (m_reference)
+         {
+            m_reference->moveTo(way, position);
+            m_reference->check("moveTo", position, position, m_stack, m_owner);
+         }
+      }
+
+      void moveToMRU(UInt32 way)
+      {
+         moveTo(way, 0);
+      }
+
+      static const UInt8 OWNER_NONE   = 0xfe;
+      static const UInt8 OWNER_SHARED = 0xfd;   /* Hit by several cores, no core's LRU block */
+
+   private:
+      UInt32 findPosition(UInt32 way) const
+      {
+         for (UInt32 w = 0; w < m_num_words; w++)
+         {
+            UInt64 match = matchBytes(m_stack, w, way);
+
+            if (match)
+            {
+               return 8 * w + (__builtin_ctzll(match) >> 3);
+            }
+         }
+
+         LOG_PRINT_ERROR("Way %u not in recency stack", way);
+      }
+
+      /* High bit set in every byte of word w equal to value */
+      static UInt64 matchBytes(const UInt8 *bytes, UInt32 w, UInt8 value)
+      {
+         const UInt64 low7 = 0x7f7f7f7f7f7f7f7fULL;
+         UInt64 x;
+
+         memcpy(&x, &bytes[8 * w], sizeof(x));
+         x ^= 0x0101010101010101ULL * value;
+
+         return ~(((x & low7) + low7) | x | low7);
+      }
+
+      /* High bit set in every byte of word w in [lo, end), end <= 64. Ways
+       * are below 128, so setting the high bit first keeps the subtractions
+       * from borrowing across bytes; the padding (0xff) is masked out. */
+      static UInt64 matchRange(const UInt8 *bytes, UInt32 w, UInt32 lo, UInt32 end)
+      {
+         const UInt64 ones = 0x0101010101010101ULL;
+         const UInt64 high = 0x8080808080808080ULL;
+         UInt64 x;
+
+         memcpy(&x, &bytes[8 * w], sizeof(x));
+
+         UInt64 ge_lo  = (x | high) - ones * lo;
+         UInt64 ge_end = (x | high) - ones * end;
+
+         return ge_lo & ~ge_end & ~x & high;
+      }
+
+      const UInt32 m_associativity;
+      const UInt32 m_num_words;
+            UInt8 *m_stack;
+            UInt8 *m_owner;
+      RecencyReference *m_reference;   /* Lockstep checker, NULL unless enabled */
+};
+
+#endif /* CACHE_SET_RECENCY_STACK_H */
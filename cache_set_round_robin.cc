@@ -1,4 +1,5 @@
 #include "cache_set_round_robin.h"
+#include "log.h"
 
 CacheSetRoundRobin::CacheSetRoundRobin(
       CacheBase::cache_t cache_type,
@@ -6,6 +7,7 @@ CacheSetRoundRobin::CacheSetRoundRobin(
    CacheSet(cache_type, associativity, blocksize)
 {
    m_replacement_index = m_associativity - 1;
+   m_all_ways = allWaysMask(m_associativity);
 }
 
 CacheSetRoundRobin::~CacheSetRoundRobin()
@@ -14,13 +16,24 @@ CacheSetRoundRobin::~CacheSetRoundRobin()
 UInt32
 CacheSetRoundRobin::getReplacementIndex(CacheCntlr *cntlr,core_id_t core_id)
 {
-   UInt32 curr_replacement_index = m_replacement_index;
-   m_replacement_index = (m_replacement_index == 0) ? (m_associativity-1) : (m_replacement_index-1);
+   /* The pointer walks down from the last way; ways that cannot be replaced
+    * right now are skipped */
+   UInt64 candidates = m_all_ways;
 
-   if (!isValidReplacement(m_replacement_index))
-      return getReplacementIndex(cntlr,core_id);
-   else
-      return curr_replacement_index;
+   while (candidates)
+   {
+      UInt32 index = prevWayInMask(candidates, m_replacement_index);
+
+      if (isValidReplacement(index))
+      {
+         m_replacement_index = (index == 0) ? (m_associativity-1) : (index-1);
+         return index;
+      }
+
+      candidates &= ~(UInt64(1) << index);
+   }
+
+   LOG_PRINT_ERROR("Error finding replacement index");
 }
 
 void
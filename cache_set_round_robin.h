@@ -2,6 +2,7 @@
 #define CACHE_SET_ROUND_ROBIN_H
 
 #include "cache_set.h"
+#include "cache_set_way_mask.h"
 
 class CacheSetRoundRobin : public CacheSet
 {
@@ -15,6 +16,7 @@ class CacheSetRoundRobin : public CacheSet
 
    private:
       UInt32 m_replacement_index;
+      UInt64 m_all_ways;
 };
 
 #endif /* CACHE_SET_ROUND_ROBIN_H */
@@ -0,0 +1,90 @@
+#include "cache_set_rrip_kernel.h"
+#include "log.h"
+
+/* Specialized kernels: ASSOC and RRIP_MAX are template arguments, so every
+ * loop below has a constant trip count and gets unrolled by the compiler. */
+template <UInt32 ASSOC, UInt8 RRIP_MAX>
+static UInt64 rripMaxMask(const UInt8 *rrip_bits, UInt32, UInt8)
+{
+   UInt64 mask = 0;
+
+   for (UInt32 i = 0; i < ASSOC; i++)
+      mask |= UInt64(rrip_bits[i] >= RRIP_MAX) << i;
+
+   return mask;
+}
+
+template <UInt32 ASSOC, UInt8 RRIP_MAX>
+static void rripAge(UInt8 *rrip_bits, UInt32, UInt8)
+{
+   UInt8 oldest = 0;
+
+   for (UInt32 i = 0; i < ASSOC; i++)
+      oldest = (rrip_bits[i] > oldest) ? rrip_bits[i] : oldest;
+
+   const UInt8 delta = RRIP_MAX - oldest;
+
+   for (UInt32 i = 0; i < ASSOC; i++)
+      rrip_bits[i] += delta;
+}
+
+/* Generic kernel, any associativity up to 64 and any RRPV width */
+static UInt64 rripMaxMaskGeneric(const UInt8 *rrip_bits, UInt32 associativity, UInt8 rrip_max)
+{
+   UInt64 mask = 0;
+
+   for (UInt32 i = 0; i < associativity; i++)
+      mask |= UInt64(rrip_bits[i] >= rrip_max) << i;
+
+   return mask;
+}
+
+static void rripAgeGeneric(UInt8 *rrip_bits, UInt32 associativity, UInt8 rrip_max)
+{
+   UInt8 oldest = 0;
+
+   for (UInt32 i = 0; i < associativity; i++)
+      oldest = (rrip_bits[i] > oldest) ? rrip_bits[i] : oldest;
+
+   const UInt8 delta = rrip_max - oldest;
+
+   for (UInt32 i = 0; i < associativity; i++)
+      rrip_bits[i] += delta;
+}
+
+#define RRIP_KERNEL(assoc, bits) \
+   { &rripMaxMask<assoc, (1 << bits) - 1>, &rripAge<assoc, (1 << bits) - 1>, #assoc "-way/" #bits "-bit" }
+
+static const RRIPKernel g_rrip_kernels[] =
+{
+   RRIP_KERNEL(8, 2),  RRIP_KERNEL(8, 3),
+   RRIP_KERNEL(16, 2), RRIP_KERNEL(16, 3),
+   RRIP_KERNEL(32, 2), RRIP_KERNEL(32, 3),
+};
+
+static const RRIPKernel g_rrip_kernel_generic =
+   { &rripMaxMaskGeneric, &rripAgeGeneric, "generic" };
+
+const RRIPKernel* getRRIPKernel(UInt32 associativity, UInt8 rrip_max)
+{
+   LOG_ASSERT_ERROR(associativity <= 64, "RRIP kernels support up to 64 ways, not %u", associativity);
+
+   UInt32 assoc_index, bits_index;
+
+   switch (associativity)
+   {
+      case 8:  assoc_index = 0; break;
+      case 16: assoc_index = 1; break;
+      case 32: assoc_index = 2; break;
+      default: return &g_rrip_kernel_generic;
+   }
+
+   switch (rrip_max)
+   {
+      case 3:  bits_index = 0; break;
+      case 7:  bits_index = 1; break;
+      default: return &g_rrip_kernel_generic;
+   }
+
+   return &g_rrip_kernels[2 * assoc_index + bits_index];
+}
@@ -0,0 +1,28 @@
+#ifndef CACHE_SET_RRIP_KERNEL_H
+#define CACHE_SET_RRIP_KERNEL_H
+
+#include "fixed_types.h"
+#include "cache_set_way_mask.h"
+
+/* Victim search and ageing over the per-way RRPV array of the SRRIP family
+ * (DBPV, DBPV_DYN). Specialized versions exist for 8/16/32 ways with 2 or 3
+ * RRPV bits, where every loop has a compile-time trip count. Other
+ * geometries use the generic version. The kernel is chosen once, when the
+ * set is constructed.
+ */
+struct RRIPKernel
+{
+   /* Bitmask of the ways whose RRPV is at rrip_max */
+   UInt64 (*maxMask)(const UInt8 *rrip_bits, UInt32 associativity, UInt8 rrip_max);
+
+   /* Age every way by the same amount, so that the oldest one reaches
+    * rrip_max. Same result as the SRRIP loop of one increment per round,
+    * without the rounds. Only valid when no way is at rrip_max yet. */
+   void   (*age)(UInt8 *rrip_bits, UInt32 associativity, UInt8 rrip_max);
+
+   const char *name;
+};
+
+const RRIPKernel* getRRIPKernel(UInt32 associativity, UInt8 rrip_max);
+
+#endif /* CACHE_SET_RRIP_KERNEL_H */
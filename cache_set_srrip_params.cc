@@ -0,0 +1,98 @@
+#include "cache_set_srrip_params.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <vector>
+
+/* All parameter blocks created so far; there is one per cache (and core
+ * for private caches), so this stays tiny */
+static std::vector<SRRIPParams*> g_srrip_params;
+
+SRRIPParams::SRRIPParams(String cfgname, core_id_t core_id,
+                         UInt32 associativity, UInt8 num_attempts, UInt32 needs)
+   : m_cfgname(cfgname)
+   , m_core_id(core_id)
+   , m_associativity(associativity)
+   , m_requested_attempts(num_attempts)
+   , m_needs(needs)
+{
+   config::Config *cfg = Sim()->getCfg();
+
+   rrip_numbits = cfg->getIntArray(cfgname + "/srrip/bits", core_id);
+   rrip_max     = (1 << rrip_numbits) - 1;
+   rrip_insert  = rrip_max - 1;
+
+   saturation_counter_max_value = (needs & NEEDS_DEADBLOCK) ? cfg->getIntArray(cfgname + "/srrip/max_value", core_id) : 0;
+   db_percent_threshold         = (needs & NEEDS_DEADBLOCK) ? cfg->getIntArray(cfgname + "/srrip/db_threshold", core_id) : 0;
+   dbpv_case                    = (needs & NEEDS_CASE) ? cfg->getIntArray(cfgname + "/srrip/case", core_id) : 0;
+
+   prefetch_aware              = cfg->getBoolDefault(cfgname + "/srrip/prefetch_aware", false);
+   prefetch_window             = cfg->getIntDefault(cfgname + "/srrip/prefetch_window", 1024);
+   prefetch_accuracy_threshold = cfg->getIntDefault(cfgname + "/srrip/prefetch_accuracy_threshold", 5000);
+   prefetch_bypass_threshold   = cfg->getIntDefault(cfgname + "/srrip/prefetch_bypass_threshold", 1000);
+
+   num_attempts    = (num_attempts > 1) ? num_attempts : cfg->getIntDefault(cfgname + "/srrip/qbs_attempts", 1);
+   inclusion_stats = cfg->getBoolDefault(cfgname + "/srrip/inclusion_stats", false);
+
+   kernel = getRRIPKernel(associativity, rrip_max);
+
+   autotune            = cfg->getBoolDefault(cfgname + "/srrip/autotune", false);
+   tune_period         = cfg->getIntDefault(cfgname + "/srrip/tune_period", 64);
+   tune_epoch          = cfg->getIntDefault(cfgname + "/srrip/tune_epoch", 16384);
+   tune_threshold_step = cfg->getIntDefault(cfgname + "/srrip/tune_threshold_step", 500);
+   tune_margin         = cfg->getIntDefault(cfgname + "/srrip/tune_margin", 500);
+
+   bimodal             = cfg->getBoolDefault(cfgname + "/srrip/bimodal", false);
+   bimodal_epsilon_min = cfg->getIntDefault(cfgname + "/srrip/bimodal_epsilon_min", 78);
+   bimodal_epsilon_max = cfg->getIntDefault(cfgname + "/srrip/bimodal_epsilon_max", 625);
+   bimodal_seed        = cfg->getIntDefault(cfgname + "/srrip/bimodal_seed", 1);
+   LOG_ASSERT_ERROR(bimodal_epsilon_min <= bimodal_epsilon_max, "srrip/bimodal_epsilon_min must not exceed srrip/bimodal_epsilon_max");
+
+   phase_memo        = cfg->getBoolDefault(cfgname + "/srrip/phase_memo", false);
+   phase_memo_sample = cfg->getIntDefault(cfgname + "/srrip/phase_memo_sample", 8);
+
+   deferred_hits = cfg->getBoolDefault(cfgname + "/srrip/deferred_hits", false);
+   LOG_ASSERT_ERROR(!deferred_hits || (associativity <= 64), "srrip/deferred_hits supports up to 64 ways");
+
+   fast_warming = cfg->getBoolDefault(cfgname + "/srrip/fast_warming", false);
+   LOG_ASSERT_ERROR(!(fast_warming && cfg->getBoolDefault(cfgname + "/srrip/lockstep_check", false)),
+                    "srrip/fast_warming skips the lockstep checks, do not combine them");
+
+   sharer_aware = cfg->getBoolDefault(cfgname + "/srrip/sharer_aware", false);
+   /* The sharers of a block are one bit per core in a byte */
+   LOG_ASSERT_ERROR(!sharer_aware || (cfg->getInt("general/total_cores") <= 8),
+                    "srrip/sharer_aware tracks up to 8 cores");
+
+   lifetime_stats        = cfg->getBoolDefault(cfgname + "/srrip/lifetime_stats", false);
+   lifetime_epoch_shift  = cfg->getIntDefault(cfgname + "/srrip/lifetime_epoch_shift", 10);
+   lifetime_instructions = ("instructions" == cfg->getStringDefault(cfgname + "/srrip/lifetime_clock", "cycles"));
+
+   timing_sample = cfg->getIntDefault(cfgname + "/srrip/timing_sample", 0);
+
+   lockstep_check = cfg->getBoolDefault(cfgname + "/srrip/lockstep_check", false);
+}
+
+const SRRIPParams*
+SRRIPParams::get(String cfgname, core_id_t core_id,
+                 UInt32 associativity, UInt8 num_attempts, UInt32 needs)
+{
+   /* Sets of a cache are constructed one after the other, so the most
+    * recent block is almost always the one asked for */
+   for (std::vector<SRRIPParams*>::reverse_iterator it = g_srrip_params.rbegin(); it != g_srrip_params.rend(); ++it)
+   {
+      SRRIPParams *params = *it;
+
+      if ((params->m_core_id == core_id) && (params->m_associativity == associativity)
+          && (params->m_requested_attempts == num_attempts) && (params->m_needs == needs)
+          && (params->m_cfgname == cfgname))
+      {
+         return params;
+      }
+   }
+
+   SRRIPParams *params = new SRRIPParams(cfgname, core_id, associativity, num_attempts, needs);
+   g_srrip_params.push_back(params);
+
+   return params;
+}
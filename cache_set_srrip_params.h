@@ -0,0 +1,99 @@
+#ifndef CACHE_SET_SRRIP_PARAMS_H
+#define CACHE_SET_SRRIP_PARAMS_H
+
+#include "fixed_types.h"
+#include "cache_set_rrip_kernel.h"
+
+/* srrip configuration keys of one cache. Every set of a cache used to look up
+ * its parameters in the configuration on construction, three to four
+ * String concatenations and lookups per set. Now the first set of a cache
+ * parses them into this block, and all other sets share the same,
+ * immutable block.
+ *
+ * Keys that only some policies require are read only when asked for
+ * through needs, so configurations that do not set them keep working.
+ */
+struct SRRIPParams
+{
+   enum
+   {
+      NEEDS_DEADBLOCK = 1 << 0, /* srrip/max_value, srrip/db_threshold */
+      NEEDS_CASE      = 1 << 1, /* srrip/case */
+   };
+
+   UInt8  rrip_numbits;
+   UInt8  rrip_max;
+   UInt8  rrip_insert;
+   UInt32 saturation_counter_max_value;
+   UInt32 db_percent_threshold;
+   UInt8  dbpv_case;
+
+   /* Prefetch-aware insertion (DBPV_DYN) */
+   bool   prefetch_aware;
+   UInt32 prefetch_window;
+   UInt32 prefetch_accuracy_threshold;
+   UInt32 prefetch_bypass_threshold;
+
+   /* Query based selection: QBS policy attempts, or srrip/qbs_attempts */
+   UInt8  num_attempts;
+   bool   inclusion_stats;
+
+   const RRIPKernel *kernel;
+
+   /* Online tuning of db_threshold and max_value (DBPV_DYN) */
+   bool   autotune;
+   UInt32 tune_period;
+   UInt32 tune_epoch;
+   UInt32 tune_threshold_step;
+   UInt32 tune_margin;         /* Fewer misses than the control group needed to switch, 0.01% */
+
+   /* Bimodal insertion of cores at rrip_max, epsilon in units of 0.01%
+    * (DBPV_DYN) */
+   bool   bimodal;
+   UInt32 bimodal_epsilon_min;
+   UInt32 bimodal_epsilon_max;
+   UInt32 bimodal_seed;
+
+   /* Phase signature memoization of the insertion positions (DBPV_DYN) */
+   bool   phase_memo;
+   UInt32 phase_memo_sample;
+
+   /* Hits only mark the way, promotions are applied at the next miss of the
+    * set (DBPV, DBPV_DYN) */
+   bool   deferred_hits;
+
+   /* Warm path while Sniper is not in detailed mode, see cache_set_warming.h */
+   bool   fast_warming;
+
+   /* Track the cores that hit every block; attribute hits to the hitting
+    * core and keep shared blocks out of the per-core accounting */
+   bool   sharer_aware;
+
+   /* Block lifetime histograms (DBPV_DYN), see cache_set_lifetime.h */
+   bool   lifetime_stats;
+   UInt32 lifetime_epoch_shift;
+   bool   lifetime_instructions;
+
+   /* Sample one in timing_sample policy calls for host timing, 0 is off */
+   UInt32 timing_sample;
+
+   /* Run every set in lockstep with its reference model, see
+    * cache_set_lockstep.h */
+   bool   lockstep_check;
+
+   static const SRRIPParams* get(String cfgname, core_id_t core_id,
+                                 UInt32 associativity, UInt8 num_attempts, UInt32 needs);
+
+   private:
+      SRRIPParams(String cfgname, core_id_t core_id,
+                  UInt32 associativity, UInt8 num_attempts, UInt32 needs);
+
+      /* Key of the block, sets of one cache share it */
+      String    m_cfgname;
+      core_id_t m_core_id;
+      UInt32    m_associativity;
+      UInt8     m_requested_attempts;
+      UInt32    m_needs;
+};
+
+#endif /* CACHE_SET_SRRIP_PARAMS_H */
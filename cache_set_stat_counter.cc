@@ -0,0 +1,88 @@
+#include "cache_set_stat_counter.h"
+#include "simulator.h"
+#include "stats.h"
+#include "lock.h"
+#include "log.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define CACHE_LINE_SIZE 64
+
+__thread UInt64* StatCounter::t_shard = NULL;
+
+/* Constant initialized, so counters defined as statics in other files can
+ * take their slot before dynamic initialization of this file has run */
+static UInt32 g_num_counters = 0;
+
+/* Shards of all threads that have counted something */
+static std::vector<UInt64*> *g_shards = NULL;
+static Lock *g_shards_lock = NULL;
+
+static UInt64 statCounterCallback(String objectName, UInt32 index, String metricName, UInt64 arg)
+{
+   return ((StatCounter*)arg)->get();
+}
+
+StatCounter::StatCounter()
+   : m_slot(__sync_fetch_and_add(&g_num_counters, 1))
+{
+   LOG_ASSERT_ERROR(m_slot < MAX_COUNTERS, "More than %u StatCounters", MAX_COUNTERS);
+}
+
+UInt64*
+StatCounter::allocateShard()
+{
+   void *shard = NULL;
+
+   if (posix_memalign(&shard, CACHE_LINE_SIZE, MAX_COUNTERS * sizeof(UInt64)))
+   {
+      LOG_PRINT_ERROR("Could not allocate a StatCounter shard");
+   }
+
+   memset(shard, 0, MAX_COUNTERS * sizeof(UInt64));
+
+   /* The first shard is created by a set constructor, before the
+    * simulation threads start */
+   if (NULL == g_shards_lock)
+   {
+      g_shards_lock = new Lock();
+      g_shards = new std::vector<UInt64*>();
+   }
+
+   ScopedLock sl(*g_shards_lock);
+   g_shards->push_back((UInt64*)shard);
+
+   return (UInt64*)shard;
+}
+
+UInt64
+StatCounter::get() const
+{
+   UInt64 total = 0;
+
+   if (NULL == g_shards_lock)
+   {
+      return 0;
+   }
+
+   ScopedLock sl(*g_shards_lock);
+
+   for (UInt32 i = 0; i < g_shards->size(); i++)
+   {
+      total += (*g_shards)[i][m_slot];
+   }
+
+   return total;
+}
+
+void
+StatCounter::registerMetric(String objectName, UInt32 index, String metricName)
+{
+   /* Make sure the shard list exists before the stats manager reads it */
+   shard();
+
+   Sim()->getStatsManager()->registerMetric(
+      new StatsMetricCallback(objectName, index, metricName, statCounterCallback, (UInt64)this));
+}
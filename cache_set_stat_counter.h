@@ -0,0 +1,55 @@
+#ifndef CACHE_SET_STAT_COUNTER_H
+#define CACHE_SET_STAT_COUNTER_H
+
+#include "fixed_types.h"
+
+/* Event counter for policy statistics that are bumped from the LLC access
+ * path. With several simulation threads a plain static UInt64 loses
+ * increments, and an atomic one bounces its cache line between the
+ * threads on every access.
+ *
+ * Every thread that increments a StatCounter gets its own shard: an array
+ * holding one slot per StatCounter, aligned to and padded out to whole
+ * cache lines, so two threads never write the same line. An increment is
+ * a plain add to the thread's own slot. get() sums the slots of all
+ * threads; registerMetric() hands that sum to the stats manager through a
+ * StatsMetricCallback, so the stats output sees the total.
+ *
+ * Counters only ever go up. Policy state that is read back to make
+ * decisions stays a plain variable.
+ */
+class StatCounter
+{
+   public:
+      StatCounter();
+
+      void operator++()          { shard()[m_slot]++; }
+      void operator++(int)       { shard()[m_slot]++; }
+      void operator+=(UInt64 n)  { shard()[m_slot] += n; }
+
+      /* Sum over all threads */
+      UInt64 get() const;
+
+      void registerMetric(String objectName, UInt32 index, String metricName);
+
+      static const UInt32 MAX_COUNTERS = 2048;
+
+   private:
+      static UInt64* shard()
+      {
+         if (__builtin_expect(NULL == t_shard, 0))
+         {
+            t_shard = allocateShard();
+         }
+
+         return t_shard;
+      }
+
+      static UInt64* allocateShard();
+
+      static __thread UInt64 *t_shard;
+
+      const UInt32 m_slot;
+};
+
+#endif /* CACHE_SET_STAT_COUNTER_H */
@@ -0,0 +1,71 @@
+#include "cache_set_timing.h"
+#include "log.h"
+#include "utils.h"
+
+UInt32 PolicyTimer::g_one_in_n = 0;
+__thread SInt32 PolicyTimer::t_countdown = 0;
+
+PolicyTimer::PolicyTimer(const char *policy, const char *call, UInt32 num_paths, const char * const *path_names)
+   : m_policy(policy)
+   , m_call(call)
+   , m_num_paths(num_paths)
+   , m_path_names(path_names)
+   , m_paths(NULL)
+   , m_registered(false)
+{
+}
+
+PolicyTimer::~PolicyTimer()
+{
+   delete [] m_paths;
+}
+
+void
+PolicyTimer::setSampling(UInt32 one_in_n)
+{
+   g_one_in_n = one_in_n;
+}
+
+void
+PolicyTimer::registerMetrics(UInt32 index)
+{
+   /* Counters take StatCounter slots, only timers in use get them */
+   if (m_registered || !isEnabled())
+   {
+      return;
+   }
+
+   m_registered = true;
+   m_paths = new Path[m_num_paths];
+
+   for (UInt32 p = 0; p < m_num_paths; p++)
+   {
+      String prefix = String("timing-") + m_policy + "-" + m_call + "-" + m_path_names[p];
+
+      m_paths[p].samples.registerMetric("interval_timer", index, prefix + "-samples");
+      m_paths[p].cycles.registerMetric("interval_timer", index, prefix + "-cycles");
+
+      for (UInt32 b = 0; b < NUM_BUCKETS; b++)
+      {
+         m_paths[p].hist[b].registerMetric("interval_timer", index, prefix + "-hist-" + itostr(b));
+      }
+   }
+}
+
+void
+PolicyTimer::record(UInt32 path, UInt64 cycles)
+{
+   /* Sampling was enabled after this timer was set up */
+   if (NULL == m_paths)
+   {
+      return;
+   }
+
+   LOG_ASSERT_ERROR(path < m_num_paths, "Timing path %u out of range for %s %s", path, m_policy, m_call);
+
+   UInt32 bucket = (cycles > 0) ? 63 - __builtin_clzll(cycles) : 0;
+
+   m_paths[path].samples++;
+   m_paths[path].cycles += cycles;
+   m_paths[path].hist[(bucket < NUM_BUCKETS) ? bucket : NUM_BUCKETS - 1]++;
+}
@@ -0,0 +1,77 @@
+#ifndef CACHE_SET_TIMING_H
+#define CACHE_SET_TIMING_H
+
+#include "fixed_types.h"
+#include "cache_set_stat_counter.h"
+
+/* Host-time instrumentation of the replacement policy calls
+ * (srrip/timing_sample = N, 0 is off).
+ *
+ * One PolicyTimer per policy and call (e.g. DBPV_DYN miss). Every thread
+ * samples one in N calls: start() reads the TSC, stop() reads it again and
+ * attributes the host cycles to the code path the call took (invalid way,
+ * victim after k ageing rounds, ...). Per path there is a sample count,
+ * the total cycles and a log2 histogram, all StatCounters, so threads
+ * update only their own shard and the totals appear with the interval
+ * stats as timing-<policy>-<call>-<path>-{samples,cycles,hist-<b>}.
+ *
+ * Not sampled, a call costs one thread-local decrement and compare.
+ */
+class PolicyTimer
+{
+   public:
+      PolicyTimer(const char *policy, const char *call, UInt32 num_paths, const char * const *path_names);
+      ~PolicyTimer();
+
+      /* Sample one in one_in_n calls of every timer, 0 disables timing */
+      static void setSampling(UInt32 one_in_n);
+      static bool isEnabled() { return g_one_in_n > 0; }
+
+      /* TSC at the start of a sampled call, 0 if the call is not sampled */
+      static UInt64 start()
+      {
+         if (__builtin_expect(0 == g_one_in_n, 1) || (--t_countdown > 0))
+         {
+            return 0;
+         }
+
+         t_countdown = g_one_in_n;
+         return __builtin_ia32_rdtsc();
+      }
+
+      void stop(UInt64 start_tsc, UInt32 path)
+      {
+         if (__builtin_expect(0 != start_tsc, 0))
+         {
+            record(path, __builtin_ia32_rdtsc() - start_tsc);
+         }
+      }
+
+      void registerMetrics(UInt32 index);
+
+      /* Histogram bucket b counts samples of [2^b, 2^(b+1)) cycles, the last
+       * one everything above */
+      static const UInt32 NUM_BUCKETS = 20;
+
+   private:
+      struct Path
+      {
+         StatCounter samples;
+         StatCounter cycles;
+         StatCounter hist[NUM_BUCKETS];
+      };
+
+      void record(UInt32 path, UInt64 cycles);
+
+      const char  *m_policy;
+      const char  *m_call;
+      const UInt32 m_num_paths;
+      const char * const *m_path_names;
+            Path  *m_paths;
+            bool   m_registered;
+
+      static UInt32 g_one_in_n;
+      static __thread SInt32 t_countdown;
+};
+
+#endif /* CACHE_SET_TIMING_H */
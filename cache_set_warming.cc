@@ -0,0 +1,51 @@
+#include "cache_set_warming.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+#include "inst_mode.h"
+#include "log.h"
+
+#include <vector>
+#include <algorithm>
+
+bool PolicyWarming::g_warming = false;
+
+static std::vector<void (*)()> g_handoffs;
+static bool g_hooked = false;
+
+void
+PolicyWarming::enable(void (*handoff)())
+{
+   if (!g_hooked)
+   {
+      g_hooked = true;
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_INSTRUMENT_MODE, instrumentModeChanged, 0);
+      g_warming = (InstMode::DETAILED != Sim()->getInstrumentationMode());
+   }
+
+   if ((NULL == handoff) || (std::find(g_handoffs.begin(), g_handoffs.end(), handoff) != g_handoffs.end()))
+   {
+      return;
+   }
+
+   g_handoffs.push_back(handoff);
+}
+
+SInt64
+PolicyWarming::instrumentModeChanged(UInt64 arg, UInt64 mode)
+{
+   bool warming = (InstMode::DETAILED != (InstMode::inst_mode_t)mode);
+
+   if (g_warming && !warming)
+   {
+      printf("[Newton] Policy warming done, handing off to detailed mode\n");
+
+      for (UInt32 i = 0; i < g_handoffs.size(); i++)
+      {
+         g_handoffs[i]();
+      }
+   }
+
+   g_warming = warming;
+
+   return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef CACHE_SET_WARMING_H
+#define CACHE_SET_WARMING_H
+
+#include "fixed_types.h"
+
+/* Functional warming of the replacement policies (srrip/fast_warming).
+ *
+ * While Sniper is not in detailed mode (cache-only warming), a policy
+ * that enabled warming takes its warm path: tags and the replacement
+ * state proper (RRPV, recency order, owner) are kept up to date, but no
+ * statistics are counted, nothing is printed and the adaptive parts
+ * (DAAIP windows and tuning, UCP repartitioning) are frozen.
+ *
+ * On the switch to detailed mode every registered handoff function is
+ * called, so the policies start their windows and epochs from zero with
+ * warm caches.
+ */
+class PolicyWarming
+{
+   public:
+      /* Follow the instrumentation mode; handoff (may be NULL) is called on
+       * every switch to detailed mode. Safe to call once per set. */
+      static void enable(void (*handoff)());
+
+      static bool isWarming() { return g_warming; }
+
+   private:
+      static SInt64 instrumentModeChanged(UInt64 arg, UInt64 mode);
+
+      static bool g_warming;
+};
+
+#endif /* CACHE_SET_WARMING_H */
@@ -0,0 +1,49 @@
+#ifndef CACHE_SET_WAY_MASK_H
+#define CACHE_SET_WAY_MASK_H
+
+#include "fixed_types.h"
+#include "log.h"
+#include "cache_block_info.h"
+
+/* Helpers for policies that keep their per-way state as one bit per way in a
+ * 64-bit word (NRU, NMRU, MRU, round-robin, the SRRIP candidate masks).
+ * Bit i is way i. */
+
+static inline UInt64 allWaysMask(UInt32 associativity)
+{
+   LOG_ASSERT_ERROR(associativity <= 64, "Way masks support up to 64 ways, not %u", associativity);
+
+   return (64 == associativity) ? ~UInt64(0) : ((UInt64(1) << associativity) - 1);
+}
+
+/* First way of a non-empty mask at or after start, wrapping around; for
+ * SRRIP this is the way the replacement pointer sweep stops at */
+static inline UInt32 nextWayInMask(UInt64 mask, UInt32 start)
+{
+   UInt64 upper = mask & (~UInt64(0) << start);
+
+   return __builtin_ctzll(upper ? upper : mask);
+}
+
+/* First way of a non-empty mask at or before start, wrapping around */
+static inline UInt32 prevWayInMask(UInt64 mask, UInt32 start)
+{
+   UInt64 lower = mask & (~UInt64(0) >> (63 - start));
+
+   return 63 - __builtin_clzll(lower ? lower : mask);
+}
+
+/* Invalid ways of a set as a mask */
+static inline UInt64 invalidWaysMask(CacheBlockInfo **blocks, UInt32 associativity)
+{
+   UInt64 invalid = 0;
+
+   for (UInt32 i = 0; i < associativity; i++)
+   {
+      invalid |= UInt64(!blocks[i]->isValid()) << i;
+   }
+
+   return invalid;
+}
+
+#endif /* CACHE_SET_WAY_MASK_H */